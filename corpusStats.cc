@@ -0,0 +1,301 @@
+#include <string>
+#include <algorithm>
+#include <iomanip>
+#include <string.h>
+#include "corpusStats.hpp"
+#include "sfdBuffer.hpp"
+#include "sfdTok.hpp"
+#include "threadPool.hpp"
+#include "runStats.hpp"
+#include "jlog.hpp"
+//! \file corpusStats.cc
+//! \brief CorpusStats implementation
+
+//! Create an empty comparison.
+CorpusStats::CorpusStats () : listNames (false)
+{
+}
+
+//! \fn int CorpusStats::compare (const string& refFile, const vector<string>& fontFiles, unsigned int threads, bool listNames)
+//! \brief Read the glyph names of the reference font and of the fonts,
+//! then compare each font with the reference. Each file is read once, the
+//! files are read and compared in parallel.
+//! \param [in] refFile The reference SFD file.
+//! \param [in] fontFiles The SFD files compared with the reference.
+//! \param [in] threads Number of files read in parallel.
+//! \param [in] listNames Keep the names only one of the fonts has.
+//! \returns SUCCESS if all the files were read.
+//! \returns FAIL if a file cannot be read. The other fonts are still
+//! compared unless it is the reference, then all the fonts fail.
+int CorpusStats::compare (const string& refFile,
+	const vector<string>& fontFiles, unsigned int threads, bool listNames)
+{
+	this->listNames = listNames;
+	ref.fileName = refFile;
+	for (unsigned int i = 0; i < fontFiles.size (); i++)
+	{
+		fonts.push_back (make_unique<CorpusFont> ());
+		fonts[i]->fileName = fontFiles[i];
+	}
+
+	if (threads > fonts.size () + 1)
+	{
+		threads = fonts.size () + 1;
+	}
+	if (threads == 0)
+	{
+		threads = 1;
+	}
+	jLOG ("Reading " << fonts.size () + 1 << " SFD file(s) on " << threads
+		<< " thread(s)");
+
+	ThreadPool pool (threads);
+	pool.submit ([this] ()
+		{
+			ref.result = loadGlyphNames (ref);
+		});
+	for (unsigned int i = 0; i < fonts.size (); i++)
+	{
+		CorpusFont *font = fonts[i].get ();
+		pool.submit ([font] ()
+			{
+				font->result = loadGlyphNames (*font);
+			});
+	}
+	pool.wait ();
+	if (ref.result != SUCCESS)
+	{
+		//! Without the reference none of the fonts can be compared.
+		for (unsigned int i = 0; i < fonts.size (); i++)
+		{
+			fonts[i]->result = FAIL;
+		}
+		return FAIL;
+	}
+
+	//! The reference is only looked up from here on.
+	int retVal = SUCCESS;
+	for (unsigned int i = 0; i < fonts.size (); i++)
+	{
+		CorpusFont *font = fonts[i].get ();
+		if (font->result != SUCCESS)
+		{
+			retVal = FAIL;
+			continue;
+		}
+		pool.submit ([this, font] ()
+			{
+				compareFont (*font);
+			});
+	}
+	pool.wait ();
+	return retVal;
+}
+
+//! \fn int CorpusStats::loadGlyphNames (CorpusFont& font)
+//! \brief Read the names of the StartChar lines of a SFD file into the
+//! names of the font. The search for the next StartChar line skips the
+//! other lines without splitting them.
+//! \param [in,out] font The font, fileName is read.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be read or a StartChar line has no
+//! name.
+int CorpusStats::loadGlyphNames (CorpusFont& font)
+{
+	SfdBuffer sfdBuf;
+	if (sfdBuf.loadFile (font.fileName.c_str ()) != SUCCESS)
+	{
+		jERR ("Error : Unable to load SFD file " << font.fileName);
+		return FAIL;
+	}
+
+	const char *data = sfdBuf.getData ();
+	const char *dataEnd = data + sfdBuf.getSize ();
+	string startLine = string ("\n") + START_CHAR_TEXT;
+	SfdTokenizer tok;
+
+	//! Point at the newline before each StartChar line, the first line of
+	//! the file has none.
+	const char *found = data - 1;
+	if ((size_t) (dataEnd - data) < startLine.size () - 1
+		|| (memcmp (data, START_CHAR_TEXT, startLine.size () - 1) != 0))
+	{
+		found = (const char *) memmem (data, dataEnd - data,
+			startLine.data (), startLine.size ());
+	}
+	while (found != NULL)
+	{
+		const char *lineStart = found + 1;
+		const char *lineEnd = (const char *) memchr (lineStart, '\n',
+			dataEnd - lineStart);
+		if (lineEnd == NULL)
+		{
+			lineEnd = dataEnd;
+		}
+		string_view line (lineStart, lineEnd - lineStart);
+		string_view glyphName;
+		tok.split (line, ' ');
+		if (tok.getTok (2, glyphName) != SUCCESS)
+		{
+			jERR ("Error : No glyph name in [" << line << "] of "
+				<< font.fileName);
+			return FAIL;
+		}
+		font.names.intern (glyphName);
+		found = (const char *) memmem (lineEnd, dataEnd - lineEnd,
+			startLine.data (), startLine.size ());
+	}
+
+	//! The table holds the empty name besides the glyph names.
+	font.glyphCount = font.names.getCount () - 1;
+	jDBG (font.fileName << " : " << font.glyphCount << " glyph name(s)");
+	return SUCCESS;
+}
+
+//! \fn void CorpusStats::compareFont (CorpusFont& font)
+//! \brief Count the names of the font found in the reference and the
+//! names only one of them has, and list the latter with listNames.
+//! \param [in,out] font The font, read by loadGlyphNames ().
+void CorpusStats::compareFont (CorpusFont& font)
+{
+	for (unsigned int id = NO_NAME + 1; id < font.names.getCount (); id++)
+	{
+		const string& name = font.names.getName (id);
+		if (ref.names.findId (name) != NO_ID)
+		{
+			font.common++;
+		}
+		else
+		{
+			font.uniqueFont++;
+			if (listNames)
+			{
+				font.uniqueFontNames.push_back (name);
+			}
+		}
+	}
+	font.uniqueRef = ref.glyphCount - font.common;
+
+	if (listNames)
+	{
+		for (unsigned int id = NO_NAME + 1; id < ref.names.getCount (); id++)
+		{
+			const string& name = ref.names.getName (id);
+			if (font.names.findId (name) == NO_ID)
+			{
+				font.uniqueRefNames.push_back (name);
+			}
+		}
+		sort (font.uniqueRefNames.begin (), font.uniqueRefNames.end ());
+		sort (font.uniqueFontNames.begin (), font.uniqueFontNames.end ());
+	}
+}
+
+//! \fn void CorpusStats::printText (ostream& out)
+//! \brief Write a row per font with the counts, followed by the names
+//! only one of the fonts has when they are listed.
+//! \param [in] out The stream.
+void CorpusStats::printText (ostream& out)
+{
+	string rule (83, '-');
+
+	out << "Reference " << ref.fileName << " : " << ref.glyphCount
+		<< " glyph name(s)\n";
+	out << rule << "\n";
+	out << left << setw (25) << "Fonts v / Glyphs >" << right
+		<< " |" << setw (20) << "Unique in reference"
+		<< " |" << setw (15) << "Unique in font"
+		<< " |" << setw (15) << "Common" << " |\n";
+	out << rule << "\n";
+	for (unsigned int i = 0; i < fonts.size (); i++)
+	{
+		CorpusFont& font = *fonts[i];
+		out << left << setw (25) << font.fileName << right << " |";
+		if (font.result != SUCCESS)
+		{
+			out << setw (20) << "failed" << " |" << setw (15) << "-"
+				<< " |" << setw (15) << "-" << " |\n";
+			continue;
+		}
+		out << setw (20) << font.uniqueRef << " |" << setw (15)
+			<< font.uniqueFont << " |" << setw (15) << font.common << " |\n";
+	}
+	out << rule << "\n";
+
+	if (!listNames)
+	{
+		return;
+	}
+	for (unsigned int i = 0; i < fonts.size (); i++)
+	{
+		CorpusFont& font = *fonts[i];
+		if (font.result != SUCCESS)
+		{
+			continue;
+		}
+		out << "\nOnly in " << ref.fileName << ", not in " << font.fileName
+			<< " (" << font.uniqueRef << ")\n";
+		for (unsigned int j = 0; j < font.uniqueRefNames.size (); j++)
+		{
+			out << "\t" << font.uniqueRefNames[j] << "\n";
+		}
+		out << "\nOnly in " << font.fileName << ", not in " << ref.fileName
+			<< " (" << font.uniqueFont << ")\n";
+		for (unsigned int j = 0; j < font.uniqueFontNames.size (); j++)
+		{
+			out << "\t" << font.uniqueFontNames[j] << "\n";
+		}
+	}
+}
+
+//! \fn void CorpusStats::printNamesJson (ostream& out, const vector<string>& names)
+//! \brief Write a list of glyph names as a JSON array.
+//! \param [in] out The stream.
+//! \param [in] names The names.
+void CorpusStats::printNamesJson (ostream& out, const vector<string>& names)
+{
+	out << "[";
+	for (unsigned int i = 0; i < names.size (); i++)
+	{
+		if (i > 0)
+		{
+			out << ", ";
+		}
+		printJsonString (out, names[i]);
+	}
+	out << "]";
+}
+
+//! \fn void CorpusStats::printJson (ostream& out)
+//! \brief Write the reference and an object per font with the counts, and
+//! the names only one of the fonts has when they are listed.
+//! \param [in] out The stream.
+void CorpusStats::printJson (ostream& out)
+{
+	out << "{\n  \"reference\": {\"file\": ";
+	printJsonString (out, ref.fileName);
+	out << ", \"glyphs\": " << ref.glyphCount << "},\n  \"fonts\": [";
+	for (unsigned int i = 0; i < fonts.size (); i++)
+	{
+		CorpusFont& font = *fonts[i];
+		out << ((i == 0) ? "\n" : ",\n") << "    {\"file\": ";
+		printJsonString (out, font.fileName);
+		out << ", \"success\": " << ((font.result == SUCCESS) ? "true" : "false");
+		if (font.result == SUCCESS)
+		{
+			out << ", \"glyphs\": " << font.glyphCount
+				<< ", \"unique_ref\": " << font.uniqueRef
+				<< ", \"unique_font\": " << font.uniqueFont
+				<< ", \"common\": " << font.common;
+			if (listNames)
+			{
+				out << ",\n     \"unique_ref_names\": ";
+				printNamesJson (out, font.uniqueRefNames);
+				out << ",\n     \"unique_font_names\": ";
+				printNamesJson (out, font.uniqueFontNames);
+			}
+		}
+		out << "}";
+	}
+	out << "\n  ]\n}\n";
+}
@@ -0,0 +1,60 @@
+#ifndef __CORPUSSTATS_H
+#define __CORPUSSTATS_H
+using namespace std;
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#include "fontClass.hpp"
+//! \file corpusStats.hpp
+//! \brief Compare the glyph sets of SFD files with a reference font.
+
+//! The glyph names of a SFD file read by CorpusStats.
+struct CorpusFont
+{
+	string fileName; //!< Name of the SFD file.
+	NameTable names; //!< The StartChar names of the file, each once.
+	int result = FAIL; //!< Return value of loadGlyphNames ().
+	unsigned int glyphCount = 0; //!< Distinct glyph names in the file.
+	unsigned int uniqueRef = 0; //!< Names only in the reference font.
+	unsigned int uniqueFont = 0; //!< Names only in this font.
+	unsigned int common = 0; //!< Names in both fonts.
+	vector<string> uniqueRefNames; //!< Names only in the reference, sorted.
+	vector<string> uniqueFontNames; //!< Names only in this font, sorted.
+};
+
+//! Reads the glyph names of a reference font and of the fonts compared
+//! with it, a file per thread, and counts the names each font shares with
+//! the reference and the names only one of them has. The names are
+//! compared as sets, a name repeated in a file counts once.
+class CorpusStats
+{
+public:
+	CorpusStats ();
+	CorpusStats (const CorpusStats&) = delete;
+	CorpusStats& operator= (const CorpusStats&) = delete;
+
+	//! Read the files and compare the fonts with the reference.
+	int compare (const string& refFile, const vector<string>& fontFiles, unsigned int threads, bool listNames);
+
+	//! Write the comparison as a table.
+	void printText (ostream& out);
+
+	//! Write the comparison as a JSON object.
+	void printJson (ostream& out);
+private:
+	//! Read the StartChar names of a SFD file.
+	static int loadGlyphNames (CorpusFont& font);
+
+	//! Compare the names of a font with those of the reference.
+	void compareFont (CorpusFont& font);
+
+	//! Write a list of names as a JSON array.
+	static void printNamesJson (ostream& out, const vector<string>& names);
+
+	CorpusFont ref; //!< The reference font.
+	vector<unique_ptr<CorpusFont> > fonts; //!< The fonts compared, in order.
+	bool listNames; //!< Keep the names only one of the fonts has.
+};
+
+#endif
@@ -1,265 +1,510 @@
 #include <iostream>
+#include <sstream>
 #include "fontClass.hpp"
 #include "jlog.hpp"
 //! \file fontClass.cc 
 //! \brief fontClass implementation
 
-// Ligature methods ////////////////////
-//! set method for form
-void Ligature::setForm (string inForm)
+// NameTable methods ////////////////////
+
+//! Create the table with the empty name as NO_NAME.
+NameTable::NameTable ()
 {
-	form = inForm;
+	intern ("");
 }
 
-//! get method for form
-string Ligature::getForm (void)
+//! \fn int NameTable::intern (string_view name)
+//! \brief Get the ID of the name, add the name if it is not present.
+//! \param [in] name The glyph name.
+//! \returns ID of the name.
+int NameTable::intern (string_view name)
 {
-	return form;
+	unordered_map<string_view, int>::iterator i = ids.find (name);
+	if (i != ids.end ())
+	{
+		return (*i).second;
+	}
+
+	int id = names.size ();
+	names.push_back (string (name));
+	ids[names.back ()] = id;
+	return id;
 }
 
-//! add glyph name to the list
-void Ligature::addGlypToList (string glyphName)
+//! \fn int NameTable::findId (string_view name)
+//! \brief Get the ID of the name.
+//! \param [in] name The glyph name.
+//! \returns ID of the name, NO_ID if the name is not present.
+int NameTable::findId (string_view name)
 {
-	glyphNames.push_back (glyphName);	
+	unordered_map<string_view, int>::iterator i = ids.find (name);
+	if (i == ids.end ())
+	{
+		return NO_ID;
+	}
+	return (*i).second;
 }
 
-//! Get the size of the glyph name list.
-unsigned int Ligature::getGlypListSize (void)
+//! Get the name of the ID.
+const string& NameTable::getName (int id)
 {
-	return glyphNames.size ();
+	return names[id];
 }
 
-//! \fn int Ligature::getNthglyphName (unsigned int idx, string& out)
-//! \brief Get the nth name from the glyphName list.
-//! \param [in] idx index of the element starting from 0
-//! \param [out] out The name of glyph
-//! \returns SUCCESS if operation is successful
-//! \returns FAIL if operation is failure or index is out of bound.
-int Ligature::getNthglyphName (unsigned int idx, string& out)
+//! Get the number of names in the table.
+unsigned int NameTable::getCount (void)
 {
-	if (idx > this->getGlypListSize ())
-	{
-		jERR  ("getNthglyphName: Index out of bound");
-		return FAIL;
-	}
+	return names.size ();
+}
 
-	out = glyphNames[idx];
+// GlyphStore methods ////////////////////
 
-	return SUCCESS;
+//! Create an empty store, the offset arrays hold the end of the data.
+GlyphStore::GlyphStore ()
+{
+	ligStart.push_back (0);
+	compStart.push_back (0);
 }
 
-//! Display the Ligature data
-void Ligature::displayData ()
+//! \fn void GlyphStore::addLigature (string_view form)
+//! \brief Start a ligature, it belongs to the next glyph added.
+//! \param [in] form Form of the ligature, packed into its form code.
+void GlyphStore::addLigature (string_view form)
 {
-	jTRACE ("Form 		: " << getForm ());
-	for (unsigned int i = 0; i < glyphNames.size (); i++)
-	{
-		jTRACE ("Glyphname	: " << glyphNames[i]);
-	}
+	formCode.push_back (packForm (form));
+	compStart.push_back (comps.size ());
+}
+
+//! Add a glyph name ID to the last ligature.
+void GlyphStore::addComp (int glyph)
+{
+	comps.push_back (glyph);
+	compStart.back () = comps.size ();
+}
+
+//! \fn unsigned int GlyphStore::addGlyph (int curId, int startPos, int unicodeVal, uint64_t print)
+//! \brief Add a glyph with the ligatures added since the previous glyph.
+//! \param [in] curId ID of the name of the glyph.
+//! \param [in] startPos Starting position of the glyph, from Encoding.
+//! \param [in] unicodeVal Code point of the glyph.
+//! \param [in] print Fingerprint of the glyph.
+//! \returns Index of the glyph.
+unsigned int GlyphStore::addGlyph (int curId, int startPos, int unicodeVal,
+	uint64_t print)
+{
+	this->startPos.push_back (startPos);
+	this->unicodeVal.push_back (unicodeVal);
+	curName.push_back (curId);
+	newName.push_back (NO_NAME);
+	builtName.push_back (NO_NAME);
+	fingerprint.push_back (print);
+	ligStart.push_back (formCode.size ());
+	return curName.size () - 1;
+}
+
+//! Get the number of ligatures waiting for their glyph.
+unsigned int GlyphStore::getOpenLigatures (void)
+{
+	return formCode.size () - ligStart.back ();
 }
 
-//! Display the Ligature data
-void Ligature::displayGlyphs ()
+//! \fn void GlyphStore::append (GlyphStore& other, const vector<int>& idMap)
+//! \brief Append the glyphs of the other store, with their name IDs
+//! changed to those of another NameTable. Ligatures not given to a glyph
+//! are left out. The other store is left empty.
+//! \param [in,out] other The store whose glyphs are appended.
+//! \param [in] idMap The new ID, indexed by the ID in other.
+void GlyphStore::append (GlyphStore& other, const vector<int>& idMap)
 {
-	string t;
-	for (unsigned int i = 0; i < glyphNames.size (); i++)
+	unsigned int glyphCount = other.getCount ();
+	unsigned int ligCount = other.ligStart[glyphCount];
+	unsigned int compCount = other.compStart[ligCount];
+	unsigned int ligBase = formCode.size ();
+	unsigned int compBase = comps.size ();
+	unsigned int i;
+
+	startPos.insert (startPos.end (), other.startPos.begin (),
+		other.startPos.end ());
+	unicodeVal.insert (unicodeVal.end (), other.unicodeVal.begin (),
+		other.unicodeVal.end ());
+	fingerprint.insert (fingerprint.end (), other.fingerprint.begin (),
+		other.fingerprint.end ());
+	for (i = 0; i < glyphCount; i++)
+	{
+		curName.push_back (idMap[other.curName[i]]);
+		newName.push_back (idMap[other.newName[i]]);
+		builtName.push_back (idMap[other.builtName[i]]);
+		ligStart.push_back (ligBase + other.ligStart[i + 1]);
+	}
+
+	formCode.insert (formCode.end (), other.formCode.begin (),
+		other.formCode.begin () + ligCount);
+	for (i = 0; i < ligCount; i++)
 	{
-		t.append (glyphNames[i]);
-		t.append (" ");
+		compStart.push_back (compBase + other.compStart[i + 1]);
 	}
-	jTRACE (t);
+	for (i = 0; i < compCount; i++)
+	{
+		comps.push_back (idMap[other.comps[i]]);
+	}
+
+	GlyphStore empty;
+	swap (other.startPos, empty.startPos);
+	swap (other.unicodeVal, empty.unicodeVal);
+	swap (other.curName, empty.curName);
+	swap (other.newName, empty.newName);
+	swap (other.builtName, empty.builtName);
+	swap (other.fingerprint, empty.fingerprint);
+	swap (other.ligStart, empty.ligStart);
+	swap (other.formCode, empty.formCode);
+	swap (other.compStart, empty.compStart);
+	swap (other.comps, empty.comps);
 }
 
-void Ligature::clearGlypName (void)
+//! Reserve memory for the glyphs, ligatures and components to be added.
+void GlyphStore::reserve (size_t glyphCount, size_t ligCount, size_t compCount)
 {
-	glyphNames.clear ();
+	startPos.reserve (startPos.size () + glyphCount);
+	unicodeVal.reserve (unicodeVal.size () + glyphCount);
+	curName.reserve (curName.size () + glyphCount);
+	newName.reserve (newName.size () + glyphCount);
+	builtName.reserve (builtName.size () + glyphCount);
+	fingerprint.reserve (fingerprint.size () + glyphCount);
+	ligStart.reserve (ligStart.size () + glyphCount);
+	formCode.reserve (formCode.size () + ligCount);
+	compStart.reserve (compStart.size () + ligCount);
+	comps.reserve (comps.size () + compCount);
 }
 
+//! Set the new and built names of all the glyphs to NO_NAME.
+void GlyphStore::resetNames (void)
+{
+	newName.assign (newName.size (), NO_NAME);
+	builtName.assign (builtName.size (), NO_NAME);
+}
 
-Ligature& Ligature::returnLigature (void)
+//! Get the number of glyphs.
+unsigned int GlyphStore::getCount (void)
 {
-	return (*this);	
+	return curName.size ();
 }
 
+//! get method for startPos
+int GlyphStore::getStartPos (unsigned int glyph)
+{
+	return startPos[glyph];
+}
 
-// FontChar methods ////////////////////
+//! Get method for curName
+int GlyphStore::getCurId (unsigned int glyph)
+{
+	return curName[glyph];
+}
 
-//! set method for startPos
-void FontChar::setStartPos (int pos)
+//! Get method for unicodeVal
+int GlyphStore::getUnicodeVal (unsigned int glyph)
 {
-	startPos = pos;
+	return unicodeVal[glyph];
 }
 
-//! get method for startPos
-int FontChar::getStartPos (void)
+//! Set method for new name
+void GlyphStore::setNewId (unsigned int glyph, int name)
 {
-	return startPos;
+	newName[glyph] = name;
 }
 
-//! Set method for curName
-void FontChar::setCurName (string name)
+//! Get method for new name
+int GlyphStore::getNewId (unsigned int glyph)
 {
-	curName = name;
+	return newName[glyph];
 }
 
-//! Get method for curName
-string FontChar::getCurName (void)
+//! Set method for builtName
+void GlyphStore::setBuiltId (unsigned int glyph, int name)
 {
-	return curName; 
+	builtName[glyph] = name;
 }
 
-//! Set method for unicodeVal
-void FontChar::setUnicodeVal (int val)
+//! Get method for builtName
+int GlyphStore::getBuiltId (unsigned int glyph)
 {
-	unicodeVal = val;
+	return builtName[glyph];
 }
 
-//! Get method for unicodeVal
-int FontChar::getUnicodeVal (void)
+//! Get method for fingerprint
+uint64_t GlyphStore::getFingerprint (unsigned int glyph)
 {
-	return unicodeVal;
+	return fingerprint[glyph];
 }
 
-//! Add ligature to the ligature vector
-void FontChar::addLigature (Ligature lg)
+//! Get the ligature count
+unsigned int GlyphStore::getLigatureCount (unsigned int glyph)
 {
-	this->ligatureList.push_back (lg);
-} 
+	return ligStart[glyph + 1] - ligStart[glyph];
+}
 
-//! Method to clear the data
-void FontChar::clearData (void)
+//! Get the first ligature of the glyph.
+unsigned int GlyphStore::getLigBegin (unsigned int glyph)
 {
-	setStartPos (0);
-	setCurName ("");
-	setUnicodeVal (0);
+	return ligStart[glyph];
+}
 
-	for (unsigned int i = 0; i < ligatureList.size (); i++)
-	{
-		ligatureList[i].clearGlypName ();
-	}
-	ligatureList.clear ();
+//! Get the ligature after the last one of the glyph.
+unsigned int GlyphStore::getLigEnd (unsigned int glyph)
+{
+	return ligStart[glyph + 1];
 }
 
-//! Set method for new name
-void FontChar::setNewName (string name)
+//! Get the form code of the ligature.
+uint32_t GlyphStore::getFormCode (unsigned int lig)
 {
-	jTRACE ("Setting new name to [" << name << "]");
-	newName = name;
+	return formCode[lig];
 }
 
-//! Get method for new name
-string FontChar::getNewName (void)
+//! Get the position of the first glyph of the ligature in comps.
+unsigned int GlyphStore::getCompBegin (unsigned int lig)
 {
-	return newName;
+	return compStart[lig];
 }
 
-//! Display method for FontChars
-void FontChar::displayData (void)
+//! Get the position after the last glyph of the ligature in comps.
+unsigned int GlyphStore::getCompEnd (unsigned int lig)
 {
-	jTRACE ("========== FontChar ==========");
-	jTRACE ("Glyph Name	: " << getCurName ());
-	// jTRACE ("New Name	: " << getNewName ());
-	jTRACE ("Start Pos	: " << getStartPos ());
-	jTRACE ("Unicodeval	: " << getUnicodeVal ());
-	jTRACE ("Ligatures	: ");
+	return compStart[lig + 1];
+}
+
+//! Get the glyph name IDs of all the ligatures.
+const int *GlyphStore::getComps (void)
+{
+	return comps.data ();
+}
 
-	jTRACE ("Ligature #	: " << ligatureList.size ());
-	for (unsigned int i = 0; i < ligatureList.size (); i++)
+//! Display the data of the glyph.
+void GlyphStore::displayData (unsigned int glyph, NameTable& names)
+{
+	if (JLOGLVL < TRACE)
 	{
-		ligatureList[i].displayData ();
+		return;
 	}
-	jTRACE ("==============================\n");;
+
+	jTRACE ("========== Glyph ==========");
+	jTRACE ("Glyph Name	: " << names.getName (getCurId (glyph)));
+	jTRACE ("Start Pos	: " << getStartPos (glyph));
+	jTRACE ("Unicodeval	: " << getUnicodeVal (glyph));
+	jTRACE ("Ligature #	: " << getLigatureCount (glyph));
+	for (unsigned int l = getLigBegin (glyph); l < getLigEnd (glyph); l++)
+	{
+		jTRACE ("Form 		: " << unpackForm (getFormCode (l)));
+		for (unsigned int k = getCompBegin (l); k < getCompEnd (l); k++)
+		{
+			jTRACE ("Glyphname	: " << names.getName (comps[k]));
+		}
+	}
+	jTRACE ("===========================\n");
 }
 
-//! Display glyph info in a different format
-void FontChar::displayGlyphs (void)
+//! \fn uint32_t GlyphStore::packForm (string_view form)
+//! \brief Pack a form of up to four characters, a feature tag, into a
+//! form code.
+//! \param [in] form The form, like akhn.
+//! \returns The characters of the form, first one in the high byte.
+//! \returns FORM_UNKNOWN if the form is longer than four characters.
+uint32_t GlyphStore::packForm (string_view form)
 {
-	jTRACE (getCurName () << ": ");
-	for (unsigned int i = 0; i < ligatureList.size (); i++)
+	if (form.length () > 4)
 	{
-		ligatureList[i].displayGlyphs ();
+		return FORM_UNKNOWN;
 	}
-	jTRACE ("");
-}
-//! Load the glyph name to the map.
-//! \fn int FontChar::loadMap (map<string, string>& nameMap)
-//! \brief Load the glyphs from the FontChar to a map.
-//! This map will be used to rename the ligatures. The old value of the
-//! ligature will  be the key and the value would be the new name.
-//! \param [out] nameMap  The map that contain old glyph
-//! name and new name.
-int FontChar::loadMap (map<string, string>& nameMap)
-{
-	for (unsigned int i = 0; i < ligatureList.size (); i++)
+
+	uint32_t code = 0;
+	for (unsigned int i = 0; i < 4; i++)
 	{
-		for (unsigned int j = 0; j < ligatureList[i].getGlypListSize(); j++)
+		code <<= 8;
+		if (i < form.length ())
 		{
-			string glyph;
-			ligatureList[i].getNthglyphName(j, glyph);
-			nameMap[glyph] = "";
+			code |= (unsigned char) form[i];
 		}
 	}
-	return SUCCESS;
+	return code;
+}
 
+//! Get the form packed into the form code.
+string GlyphStore::unpackForm (uint32_t code)
+{
+	string form;
+	if (code == FORM_UNKNOWN)
+	{
+		return "?";
+	}
+	for (int shift = 24; shift >= 0; shift -= 8)
+	{
+		char c = (code >> shift) & 0xff;
+		if (c != 0)
+		{
+			form.push_back (c);
+		}
+	}
+	return form;
 }
-//! Get the ligature count;
-int FontChar::getLigatureCount (void)
+
+// NameReserve methods ////////////////////
+
+//! Create an empty index for the names in nameTable used by glyphStore.
+NameReserve::NameReserve (NameTable& nameTable, GlyphStore& glyphStore)
+	: names (nameTable), glyphs (glyphStore)
 {
-	return ligatureList.size ();
 }
 
-//! \fn Ligature& FontChar::getLigature (unsigned int pos)
-//! Get the reference of the Nth Ligature.
-//! \param pos [in] Position of the Ligature in the vector.
-//! \returns Reference to the requested Ligature.
-//!	\returns An object dynamically allocated with Form set to "InvalidObject"
-//! if pos is out of range. The caller has to check for the InvalidObject"
-//! and free the dynamically allocated object.
-//! \note Returns a dynamically allocated object if the pos is out of range.
-//! The calling function has to check for this and free the dynamically
-//! allocated object if applicable.
-Ligature& FontChar::getLigature (unsigned int pos)
+//! Add a name to the index.
+void NameReserve::reserve (int name)
+{
+	if ((unsigned int) name >= useCount.size ())
+	{
+		useCount.resize (names.getCount (), 0);
+	}
+	useCount[name]++;
+}
+
+//! Remove a name from the index.
+void NameReserve::release (int name)
 {
-	if (pos >= ligatureList.size())
+	if (((unsigned int) name < useCount.size ()) && (useCount[name] > 0))
 	{
-		Ligature  *t = new Ligature();
-		t->setForm ("InvalidObject");
-		return (t->returnLigature ());
+		useCount[name]--;
 	}
-	return (ligatureList[pos].returnLigature());
 }
 
-// CharRefData methods ////////////////////
-//! Set method for codePtVal
-int CharRefData::setCodeptVal (int val)
+//! Add the current and new names of the glyph to the index.
+void NameReserve::addGlyph (unsigned int glyph)
 {
-	codePtVal = val;
-	return SUCCESS;
+	reserve (glyphs.getCurId (glyph));
+	reserve (glyphs.getNewId (glyph));
 }
 
-//! Get method for codePtVal
-int CharRefData::getCodeptVal (void)
+//! Set the new name of the glyph and update the index.
+void NameReserve::setNewId (unsigned int glyph, int name)
 {
-	return codePtVal;
+	jTRACE ("Setting new name to [" << names.getName (name) << "]");
+	release (glyphs.getNewId (glyph));
+	glyphs.setNewId (glyph, name);
+	reserve (name);
+}
+
+//! \fn int NameReserve::isTaken (unsigned int glyph, int name)
+//! \brief Check if the name is used by a glyph other than this one.
+//! \param [in] glyph Index of the glyph being renamed.
+//! \param [in] name ID of the name to be checked, NO_ID if the name is
+//! not in the NameTable.
+//! \returns 1 if the name is used by another glyph.
+//! \returns 0 if the name is free.
+int NameReserve::isTaken (unsigned int glyph, int name)
+{
+	if ((name == NO_ID) || ((unsigned int) name >= useCount.size ()))
+	{
+		return 0;
+	}
+
+	//! The names of the glyph itself do not count.
+	int count = useCount[name];
+	if (glyphs.getCurId (glyph) == name)
+	{
+		count--;
+	}
+	if (glyphs.getNewId (glyph) == name)
+	{
+		count--;
+	}
+	return (count > 0);
 }
 
-//! Set method for charName
-int CharRefData::setCharName (string name)
+//! \fn int NameReserve::skippedSeq (int name, string prefix, int seq)
+//! \brief Get N if name is prefix followed by N, N less than seq.
+//! \returns N, 0 if the name is not of that form.
+int NameReserve::skippedSeq (int name, string prefix, int seq)
 {
-	charName = name;
-	return SUCCESS;
+	const string& str = names.getName (name);
+	if ((str.length () <= prefix.length ())
+		|| (str.compare (0, prefix.length (), prefix) != 0)
+		|| (str[prefix.length ()] == '0'))
+	{
+		return 0;
+	}
+
+	int n = 0;
+	for (unsigned int i = prefix.length (); i < str.length (); i++)
+	{
+		if ((str[i] < '0') || (str[i] > '9') || (n >= seq))
+		{
+			return 0;
+		}
+		n = n * 10 + (str[i] - '0');
+	}
+	return (n < seq) ? n : 0;
 }
 
-//! Get method for charName
-string CharRefData::getCharName (void)
+//! \fn int NameReserve::nextFree (unsigned int glyph, int base)
+//! \brief Get the first name of the form base_N, N starting from 1, that
+//! is not used by any other glyph.
+//! \param [in] glyph Index of the glyph being renamed.
+//! \param [in] base ID of the name that is already taken.
+//! \returns ID of the free name.
+//!
+//! Names are only added while the composite glyphs are renamed, so all
+//! the names below the saved sequence number are still taken. The only
+//! exception is a name held by the glyph itself, which is free for it.
+int NameReserve::nextFree (unsigned int glyph, int base)
 {
-	return (charName);
+	string prefix = names.getName (base) + "_";
+	int& seq = nextSeq[base];
+	if (seq == 0)
+	{
+		seq = 1;
+	}
+
+	//! Check the names held by the glyph that were skipped for other
+	//! glyphs.
+	int curId = glyphs.getCurId (glyph);
+	int newId = glyphs.getNewId (glyph);
+	int curSeq = skippedSeq (curId, prefix, seq);
+	int newSeq = skippedSeq (newId, prefix, seq);
+	if ((curSeq != 0) && isTaken (glyph, curId))
+	{
+		curSeq = 0;
+	}
+	if ((newSeq != 0) && isTaken (glyph, newId))
+	{
+		newSeq = 0;
+	}
+	if ((curSeq != 0) && ((newSeq == 0) || (curSeq < newSeq)))
+	{
+		return curId;
+	}
+	if (newSeq != 0)
+	{
+		return newId;
+	}
+
+	string name;
+	while (1)
+	{
+		stringstream ss;
+		ss << prefix << seq;
+		name = ss.str ();
+		if (!isTaken (glyph, names.findId (name)))
+		{
+			break;
+		}
+		jTRACE ("[" << name << "] already taken");
+		retryCount++;
+		seq++;
+	}
+	// The name is going to be used by the glyph.
+	seq++;
+	return names.intern (name);
 }
 
-//! Display the CharRefData info
-void CharRefData::displayData (void)
+//! get method for retryCount
+unsigned long NameReserve::getRetryCount (void)
 {
-	jTRACE ("========== CharRefData ==========");
-	jTRACE ("Char Name	: " << getCharName ());
-	jTRACE ("CodePtVal	: " << getCodeptVal ());
+	return retryCount;
 }
@@ -2,8 +2,12 @@
 #define __FONTCLASS_H
 using namespace std;
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
 #include <map>
+#include <unordered_map>
+#include <stdint.h>
 //! \file fontClass.hpp
 //! \brief Class declarations for glypRen
 
@@ -22,6 +26,9 @@ using namespace std;
 //! Zero Width Joiner glyph
 #define ZWJ "ZWJ"
 
+//! First line of a SFD file
+#define SFD_MAGIC_TEXT "SplineFontDB:"
+
 //! Search string for StartChar:
 #define START_CHAR_TEXT "StartChar:"
 
@@ -34,114 +41,209 @@ using namespace std;
 //! Search string for EndChar
 #define END_CHAR_TEXT "EndChar"
 
-//! Store the ligature info of the glyphs.
-class Ligature
-{
-public:
-	//! set method for form
-	void setForm (string form);
+//! Lookups of a glyph listing glyph names, like Ligature2.
+#define SUBSTITUTION_TEXT "Substitution2:"
+#define ALTERNATE_TEXT "AlternateSubs2:"
+#define MULTIPLE_TEXT "MultipleSubs2:"
 
-	//! get method for form
-	string getForm (void);
+//! Kerning classes, followed by a line per class listing the glyphs.
+#define KERN_CLASS_TEXT "KernClass2:"
+#define VKERN_CLASS_TEXT "VKernClass2:"
 
-	//! add glyph name to the list.
-	void addGlypToList (string glyph);
+//! Mark classes and sets, followed by a line per class listing the glyphs.
+#define MARK_CLASSES_TEXT "MarkAttachClasses:"
+#define MARK_SETS_TEXT "MarkAttachSets:"
 
-	//! get the size of the glyph name list
-	unsigned int getGlypListSize (void);
+//! Start and end of a contextual lookup, its class and coverage lines
+//! list glyphs.
+#define FPST_END_TEXT "EndFPST"
 
-	//! get the nth glyph name from the glyphNames list.
-	int getNthglyphName (unsigned int index, string& out);
+//! ID of the empty glyph name, i.e. no name.
+#define NO_NAME 0
 
-	//! Display the contents
-	void displayData ();
+//! ID returned when a name is not in the NameTable.
+#define NO_ID -1
 
-	//! Display the glyphs in a different format 
-	void displayGlyphs ();
+//! Symbol table of glyph names.
+//! Each distinct glyph name is stored once and referred to by an integer
+//! ID. ID 0 (NO_NAME) is the empty name. The IDs are assigned in the order
+//! the names are added and stay valid for the lifetime of the table.
+class NameTable
+{
+public:
+	NameTable ();
+	NameTable (const NameTable&) = delete;
+	NameTable& operator= (const NameTable&) = delete;
 
-	//! Clear the list of glyph names.
-	void clearGlypName (void);
+	//! Get the ID of the name, add the name if it is not present.
+	int intern (string_view name);
 
-	//! Return a reference to the Ligature object
-	Ligature& returnLigature (void);
+	//! Get the ID of the name, NO_ID if it is not present.
+	int findId (string_view name);
+
+	//! Get the name of the ID.
+	const string& getName (int id);
+
+	//! Get the number of names in the table.
+	unsigned int getCount (void);
 private:
-	string form; //!< Form type - prebase, akhn etc.
-	vector<string> glyphNames; //!< associated glyph names.
+	deque<string> names; //!< Names indexed by ID, the strings never move.
+	unordered_map<string_view, int> ids; //!< ID of the names.
 };
 
-//! Store & manipulate the glyph information.
-class FontChar
+//! Form code of a ligature whose form is not a four character tag.
+#define FORM_UNKNOWN 0xffffffff
+
+//! Form code of the akhn form, preferred for building the new name.
+#define FORM_AKHN 0x616b686e
+
+//! Glyph data of a font, stored column by column.
+//! Every field of the glyphs is held in an array of its own indexed by
+//! the position of the glyph in the file, so a pass over one field reads
+//! contiguous memory. The ligatures are stored in compressed sparse row
+//! form: the ligatures of glyph g are ligStart[g] to ligStart[g + 1] - 1,
+//! the glyph name IDs of ligature l are comps[compStart[l]] to
+//! comps[compStart[l + 1] - 1]. The form of a ligature, the feature tag
+//! like akhn, is packed into a 32 bit code.
+//!
+//! The glyphs are added in file order. Ligatures are added before the
+//! glyph they belong to, addGlyph () gives the glyph the ligatures added
+//! since the previous glyph.
+class GlyphStore
 {
 public:
-	//! set method for startPos
-	void setStartPos (int); 
+	GlyphStore ();
+	GlyphStore (const GlyphStore&) = delete;
+	GlyphStore& operator= (const GlyphStore&) = delete;
 
-	//! get method for startPos
-	int getStartPos (void);
+	//! Start a ligature of the form for the next glyph.
+	void addLigature (string_view form);
 
-	//! Set method for curName
-	void setCurName (string name);
+	//! Add a glyph name ID to the last ligature.
+	void addComp (int glyph);
 
-	//! Get method for curName
-	string getCurName (void);
+	//! Add a glyph, it takes the ligatures not yet given to a glyph.
+	unsigned int addGlyph (int curId, int startPos, int unicodeVal, uint64_t print);
 
-	//! set method for unicodeVal
-	void setUnicodeVal (int val);
+	//! Get the number of ligatures added after the last glyph.
+	unsigned int getOpenLigatures (void);
 
-	//! get method for unicodeVal
-	int getUnicodeVal (void);
+	//! Append the glyphs of another store, changing their name IDs.
+	void append (GlyphStore& other, const vector<int>& idMap);
+
+	//! Reserve memory for the glyphs, ligatures and components.
+	void reserve (size_t glyphCount, size_t ligCount, size_t compCount);
 
-	//! Add ligature to the ligature vector
-	void addLigature (Ligature l);
+	//! Set the new and built names of all the glyphs to NO_NAME.
+	void resetNames (void);
 
-	//! Clear the data.
-	void clearData (void);
+	//! Get the number of glyphs.
+	unsigned int getCount (void);
+
+	//! get method for startPos
+	int getStartPos (unsigned int glyph);
 
-	//! Display the data stored in the class.
-	void displayData (void);
+	//! Get method for curName
+	int getCurId (unsigned int glyph);
 
-	//! Display the glyp data in a diffrent format
-	void displayGlyphs (void);
+	//! get method for unicodeVal
+	int getUnicodeVal (unsigned int glyph);
 
 	//! Set method for new name
-	void setNewName (string name);
+	void setNewId (unsigned int glyph, int name);
 
 	//! Get method for new name
-	string getNewName (void);
+	int getNewId (unsigned int glyph);
 
-	//! Load the glyph name to the map.
-	int loadMap (map<string, string>& nameMap);
+	//! Set method for builtName
+	void setBuiltId (unsigned int glyph, int name);
 
-	//! Get the ligature count
-	int getLigatureCount (void);
+	//! Get method for builtName
+	int getBuiltId (unsigned int glyph);
 
-	//! Get the reference to the nth Ligature
-	Ligature& getLigature (unsigned int pos);
-private:
-	int startPos; //!< starting position of the char in SFD
-	int endPos; //!< End position of the char in SFD
-	int unicodeVal; //!< Code point of the character
-	string curName; //!< Current name of the glyph
-	string newName; //!< New name of the glyph
+	//! Get method for fingerprint
+	uint64_t getFingerprint (unsigned int glyph);
 
-	vector<Ligature> ligatureList; //!< Ligature list.
-};
+	//! Get the number of ligatures of the glyph.
+	unsigned int getLigatureCount (unsigned int glyph);
 
+	//! Get the first ligature of the glyph.
+	unsigned int getLigBegin (unsigned int glyph);
 
-//! Store the character reference data.
-class CharRefData
+	//! Get the ligature after the last one of the glyph.
+	unsigned int getLigEnd (unsigned int glyph);
+
+	//! Get the form code of the ligature.
+	uint32_t getFormCode (unsigned int lig);
+
+	//! Get the position of the first glyph of the ligature in comps.
+	unsigned int getCompBegin (unsigned int lig);
+
+	//! Get the position after the last glyph of the ligature in comps.
+	unsigned int getCompEnd (unsigned int lig);
+
+	//! Get the glyph name IDs of all the ligatures.
+	const int *getComps (void);
+
+	//! Display the data of the glyph.
+	void displayData (unsigned int glyph, NameTable& names);
+
+	//! Pack a form into a form code.
+	static uint32_t packForm (string_view form);
+
+	//! Get the form of a form code.
+	static string unpackForm (uint32_t code);
+private:
+	vector<int> startPos; //!< Starting position of the glyph in SFD
+	vector<int> unicodeVal; //!< Code point of the glyph
+	vector<int> curName; //!< ID of the current name of the glyph
+	vector<int> newName; //!< ID of the new name of the glyph
+	vector<int> builtName; //!< ID of the name built from the ligature
+	vector<uint64_t> fingerprint; //!< Hash of the lines the name depends on
+	vector<unsigned int> ligStart; //!< First ligature of each glyph, and the end
+	vector<uint32_t> formCode; //!< Packed form of each ligature
+	vector<unsigned int> compStart; //!< First component of each ligature, and the end
+	vector<int> comps; //!< Glyph name IDs of all the ligatures
+};
+
+//! Index of the glyph names in use, current as well as new names.
+//! A name is taken if any glyph other than the one being renamed uses it.
+//! The index also remembers the next sequence number to try for each
+//! base name, so that finding a free name_N does not start from 1 again.
+class NameReserve
 {
-public :
-	int setCodeptVal (int); //!< set method for codePtVal
-	int getCodeptVal (void); //!< get method for codePtVal
+public:
+	NameReserve (NameTable& nameTable, GlyphStore& glyphStore);
+
+	//! Add the current and new names of the glyph to the index.
+	void addGlyph (unsigned int glyph);
+
+	//! Set the new name of the glyph and update the index.
+	void setNewId (unsigned int glyph, int name);
 
-	int setCharName (string name); //!< set method for charName
-	string getCharName (void); //!< get method for charName
+	//! Check if the name is used by a glyph other than this one.
+	int isTaken (unsigned int glyph, int name);
 
-	void displayData (void); //! Display the CharRefData
+	//! Get the first free name of the form base_N for the glyph.
+	int nextFree (unsigned int glyph, int base);
+
+	//! Get the number of base_N names found taken by nextFree.
+	unsigned long getRetryCount (void);
 private:
-	int codePtVal; //!< Codepoint value of the character
-	string charName; //!< Std(?) Name of the Unicode character
+	//! Add a name to the index.
+	void reserve (int name);
+
+	//! Remove a name from the index.
+	void release (int name);
+
+	//! Get N if name is base_N with N below the next sequence number.
+	int skippedSeq (int name, string prefix, int seq);
+
+	NameTable& names; //!< The names referred by the IDs.
+	GlyphStore& glyphs; //!< The glyphs holding the names.
+	vector<int> useCount; //!< Number of uses of the names, indexed by ID
+	unordered_map<int, int> nextSeq; //!< Next sequence # per base name ID
+	unsigned long retryCount = 0; //!< Taken names tried by nextFree
 };
 
 #endif 
@@ -25,73 +25,117 @@ using namespace std;
 #include <sstream>
 #include <string>
 #include <vector>
-#include <map>
+#include <algorithm>
+#include <thread>
 #include <cstdlib>
 #include <getopt.h>
-#include <limits.h>
 #include <string.h>
+#include <sys/stat.h>
 #include "fontClass.hpp"
+#include "sfdBuffer.hpp"
+#include "sfdTok.hpp"
+#include "sfdRename.hpp"
+#include "refTable.hpp"
+#include "threadPool.hpp"
+#include "runStats.hpp"
+#include "memReport.hpp"
+#include "renameServer.hpp"
+#include "sfdVerify.hpp"
+#include "corpusStats.hpp"
 #include "jlog.hpp"
 
 //! \file glyphRen.cc Rename glyphs in SFD file
 //!	\brief Rename the glyphs in a SFD file based on a standard file.
 //!
 //! Usage : glyphRen -r referenceFile -i inputSFDName -o outputSFDName
+//!		-i, -o : Repeat to rename several fonts, - for stdin or stdout
+//!		-m : Manifest with input and output SFD file names
+//!		-j : Number of fonts renamed in parallel
+//!		-c : Compile the reference file into a binary cache
+//!		-s : Report the time and counters of each phase (text or json)
+//!		-M : Report the heap use of each phase
+//!		-I : Rename only the glyphs changed since the previous run
+//!		-X : Fail a font with duplicate glyph names in the input or output
+//!		-p : Number of threads parsing each SFD file
+//!		-E : Export the names given to the glyphs as a rename map
+//!		-A : Rename the glyphs of SFD or text files using a rename map
+//!		-D : Stay resident and rename the fonts requested over a socket
+//!		-V : Verify that output SFD files are renames of the input ones
+//!		-C : Compare the glyph names of SFD files with a reference font
+//!		-N : List the glyph names only one of the fonts has, with -C
 //!		-l : Log level (DBG or TRACE)
 //!		-h : Display the help screen
 //!
-//!	1. Read the code points and the standard values from the Reference file.
-//!	2. Read all Unicode characters and the names into the list	
-//!	3. Traverse through the list of characters and set the new names
-//!		for the characters.
-//!	4. Write the new SFD file with renamed glyphs
-//!
-
-// Performance considerations are thrown out of the window. 
-
-int loadReferenceData (char *refFile, map<int, CharRefData>& ref);
-int hexStrtoInt (string hexVal);
-int analyzeSFDFile (char *inSfdFile, vector<FontChar>& vFontChar);
-int getTok (string inStr, string& out, char delim, int pos);
-int storeLigature (string sfdData, Ligature& sfdLigature);
-int renameGlyphs (map<int, CharRefData> vRefData, vector <FontChar>& vFontChar, map<string, string>& nameMap, int& renCount);
-void showMap (map<string, string> nameMap);
-int buildName (map<string, string> nameMap, vector<string> comps, string& out);
-int writeNewSFD (char *inSFDName, char *outFile, vector <FontChar>& vFontChar, map<string, string> nameMap);
-int replaceFCName (map <string, string> nameMap, string& sfdData);
-int replaceGlyphNames (map<string, string> nameMap, string& sfdData);
+//! The options are processed here, the renaming itself is done by
+//! renameFont () in sfdRename.cc, or applyRenameMap () with -A. The
+//! checks of -V are done by SfdVerifier in sfdVerify.cc, the comparison
+//! of -C by CorpusStats in corpusStats.cc.
+
+struct ProgOptions;
+struct FontJob;
+int compileReference (const char *refFile);
+int collectJobs (ProgOptions& opts, vector<FontJob>& jobs);
+int renameBatch (const RefTable& vRefData, const RenameMap& renameMap, ProgOptions& opts, vector<FontJob>& jobs);
+int renameJob (const RefTable& vRefData, const RenameMap& renameMap, ProgOptions& opts, FontJob& job);
+int loadManifest (const char *manifest, vector<FontJob>& jobs);
+int reportStats (ProgOptions& opts, PhaseStats& refStats, vector<FontJob>& jobs);
+int verifyFiles (ProgOptions& opts);
+int corpusReport (ProgOptions& opts);
 void help (char *progName);
-int processArgs (int argc, char **argv, char *inFile, char *outFile, char *refFile, string& lvl);
-int checkDups (vector<FontChar>& vFontChar, unsigned int idx, string newName);
-int processHalfForms (string curName, string newName, string& hName);
-
-//! Glyph name from the input SFD corresponding to Conjunct.
-string Conjunct;
+int processArgs (int argc, char **argv, ProgOptions& opts);
 
-//! Glyph name from the input SFD corresponding to ZWJ.
-string Zwj;
+//! Command line options.
+struct ProgOptions
+{
+	vector<string> inFiles; //!< Input SFD files, in the order given.
+	vector<string> outFiles; //!< Output SFD files, paired with inFiles.
+	string refFile; //!< Reference file.
+	string logLvl; //!< Log level (DBG, TRACE).
+	string logFile; //!< Log file, empty for stdout or stderr.
+	string manifest; //!< File listing the input and output SFD files.
+	bool compileRef = false; //!< Write the binary cache of refFile.
+	string statsFormat; //!< Statistics report, text or json. Empty for none.
+	string statsFile; //!< File for the statistics, empty for stdout.
+	bool memReport = false; //!< Report the heap use per phase.
+	RenameOptions renameOpts; //!< Options passed to renameFont ().
+	unsigned int jobs = 0; //!< Number of fonts renamed in parallel.
+	unsigned int fontThreads = 0; //!< Threads per SFD file, 0 for auto.
+	bool sfdToStdout = false; //!< A new SFD file is written to stdout.
+	string applyMap; //!< Rename map used instead of refFile, empty for none.
+	string serveSocket; //!< Socket served with --serve, empty for none.
+	vector<string> verifyFiles; //!< Input and output SFD files to verify.
+	vector<string> corpusFiles; //!< Reference and fonts for --corpus-stats.
+	bool listNames = false; //!< List the names in the --corpus-stats report.
+};
+
+//! A font to be renamed in batch mode.
+struct FontJob
+{
+	string inFile; //!< Input SFD file.
+	string outFile; //!< Output SFD file.
+	off_t size; //!< Size of the input file, larger files are started first.
+	unsigned int pos; //!< Position in the command line and manifest.
+	int result; //!< Return value of renameFont ().
+	RenameStats stats; //!< Time and counters of the phases.
+};
 
 //! \fn int main (int argc, char **argv)
 //! \brief Starting point of glyphRen.
 int main (int argc, char **argv)
 {
-
-	char inFile[PATH_MAX];
-	char outFile[PATH_MAX];
-	char refFile[PATH_MAX];
-	string logLvl;
-
-	memset (inFile, '\0', PATH_MAX);	
-	memset (outFile, '\0', PATH_MAX);	
-	memset (refFile, '\0', PATH_MAX);	
+	ProgOptions opts;
 
 	// Process the command line arguments.
-	processArgs (argc, argv, inFile, outFile, refFile, logLvl);
-	if (logLvl == "DBG")
+	processArgs (argc, argv, opts);
+	if (!opts.logFile.empty () && jlogOpen (opts.logFile.c_str ()) != 0)
+	{
+		return (2);
+	}
+	if (opts.logLvl == "DBG")
 	{
 		SETMSGLVL (DBG);
 	}
-	else if (logLvl == "TRACE")
+	else if (opts.logLvl == "TRACE")
 	{
 		SETMSGLVL (TRACE);
 	}
@@ -101,1074 +145,490 @@ int main (int argc, char **argv)
 	}
 	SETFWDT (13);
 
-	jTRACE ("inFile = " << inFile);
+	if (opts.memReport)
+	{
+		memReportEnable ();
+	}
 
-	//! Map that hold the ref data from the file.
-	map<int, CharRefData> vRefData;
-	
-	//! Vector that hold the glyph data from the SFD file.
-	vector<FontChar> vFontChar;
+	if (opts.compileRef)
+	{
+		return (compileReference (opts.refFile.c_str ()) == SUCCESS) ? 0 : 2;
+	}
 
-	int retVal;
-	//! Load the reference data 
-	retVal = loadReferenceData (refFile, vRefData);
-	if (SUCCESS != retVal)
+	if (!opts.verifyFiles.empty ())
 	{
-		jERR ("Error : loadReferenceData failed");
-		return (2);
+		return (verifyFiles (opts) == 0) ? 0 : 2;
 	}
 
-	// Print the data from the reference list
-	jTRACE ("Data from the reference list");
-	
-	jTRACE ("vRefData.size () " << vRefData.size ());
-	for (map <int, CharRefData>::iterator i = vRefData.begin ();
-			i != vRefData.end(); ++i)
+	if (!opts.corpusFiles.empty ())
 	{
-		jTRACE ("vRefData[" << (*i).first << "] = ["
-			<< (*i).second.getCharName() << "]");
+		return (corpusReport (opts) == SUCCESS) ? 0 : 2;
 	}
 
-	//! Analyze the input SFD file and load the data into FontChar class.
-	retVal = analyzeSFDFile (inFile, vFontChar);
-	if (SUCCESS != retVal)
+	vector<FontJob> jobs;
+	if (opts.serveSocket.empty () && (collectJobs (opts, jobs) != SUCCESS))
 	{
-		jERR ("Error : analyzeSFDFile failed");
 		return (2);
 	}
 
-	map<string, string> nameMap;
-	int renCount = 0;
-
-	//! Load all glyphs into a map for convenience. This map will contain
-	//! old name and new name. The "old name" will be the key.
-	for (unsigned int i = 0; i < vFontChar.size(); i++)
+	//! The new SFD file goes to stdout, the log messages and the reports
+	//! are moved to stderr.
+	if (opts.sfdToStdout && opts.logFile.empty ())
 	{
-		vFontChar[i].loadMap (nameMap);
+		jlogSetSink (stderr);
 	}
 
-	showMap (nameMap);
+	//! Table that hold the ref data from the file. It is loaded once and
+	//! only read while renaming, so the fonts in a batch share it.
+	RefTable vRefData;
 
-	int pass = 1;
-	while (1)
+	//! The rename map applied with -A, it takes the place of the reference
+	//! data and is shared by the files in the same way.
+	RenameMap renameMap;
+
+	int retVal;
+	//! Load the reference data 
+	PhaseStats refStats;
+	PhaseTimer refTimer;
+	if (!opts.applyMap.empty ())
 	{
-		jLOG ("renameGlyphs() : pass - " << pass);
-		//! Traverse the glyph info and rename the glyphs
-		retVal = renameGlyphs (vRefData, vFontChar, nameMap, renCount);
+		MemPhase memPhase (MEM_REFLOAD);
+		retVal = renameMap.load (opts.applyMap.c_str ());
+		refTimer.stop (refStats);
 		if (SUCCESS != retVal)
 		{
-			jERR ("Error : renameGlyphs failed");
 			return (2);
 		}
-
-		jLOG ("Number of glyphs renamed : " << renCount);
-		if (renCount == 0)
-		{
-			break;
-		}
-		pass++;
+		refStats.lines = renameMap.getCount () + 1;
 	}
-	
-	jDBG ("Starting writeNewSFD ========================================");
-	//! Read the SFD file again and write a new file with new glyph names.
-	retVal = writeNewSFD (inFile, outFile, vFontChar, nameMap);
-	if (SUCCESS != retVal)
-	{
-		jERR ("Error : renameGlyphs failed");
-		return (2);
-	}
-	showMap (nameMap);
-	
-}
-
-//! \fn int loadReferenceData (char *refFile, map<int, CharRefData>& ref)
-//! \brief Load the reference data from the reference file
-//! \param [in] refFile Name of the file containing reference data.
-//! \param [out] ref The CharRefData map that will hold the ref data.
-//! \returns SUCCESS if operation is successful.
-//! \returns FAIL if operation is not successful.
-int loadReferenceData (char *refFile, map<int, CharRefData>& ref)
-{
-	//! Read the data from the reference file
-	ifstream stdFile (refFile);
-	if (!stdFile.is_open())
-	{
-		jERR ("Unable to read reference file " << refFile);
-		return (FAIL);
-	}
-	
-	jLOG ("Loading Reference data");
-
-	string readLine;
-	while (getline (stdFile, readLine))
+	else
 	{
-		CharRefData t;
-		int codeValue;
-
-		string tmpStr;
-		// Extract the codepoint value which is the first token.
-		if (getTok (readLine, tmpStr, ' ', 1) == SUCCESS)
-		{
-			// Convert hex to int and store.
-			codeValue = hexStrtoInt (tmpStr);
-			t.setCodeptVal (codeValue);
-		}
-		else
-		{
-			return (FAIL);
-		}
-
-		// Extract the glyph name which is the second token.
-		if (getTok (readLine, tmpStr, ' ', 2) == SUCCESS)
 		{
-			// Set the char name
-			t.setCharName (tmpStr);
+			MemPhase memPhase (MEM_REFLOAD);
+			retVal = loadReferenceData (opts.refFile.c_str (), vRefData);
 		}
-		else
+		refTimer.stop (refStats);
+		if (SUCCESS != retVal)
 		{
-			return (FAIL);
+			jERR ("Error : loadReferenceData failed");
+			return (2);
 		}
+		refStats.bytes = vRefData.getSrcSize ();
+		refStats.lines = vRefData.getLineCount ();
 
-		ref[codeValue] = t;
-		ref[codeValue].displayData ();
+		// Print the data from the reference list
+		jTRACE ("Data from the reference list");
+		vRefData.displayData ();
 	}
-	stdFile.close ();
-	jLOG ("Finished Loading Reference data");
-	return (SUCCESS);
-}
 
-//! \fn int hexStrtoInt (string)
-//! \brief Convert a hex string to int
-//! \param [in] hexVal string containing hex value
-//! \returns int value of hex string
-int hexStrtoInt (string hexVal)
-{
-	// Convert the hex string to int.
-	int h;
-	stringstream x;
-	x << hex << hexVal;
-	x >> h;
-	return h;
-}
-
-//! \fn int analyzeSFDFile (char *inSfdName, vector<FontChar>& vFontChar)
-//! \brief Analyze the input SFD file and load the data into FontChar vector.
-//! \param [in] inSfdName Name of the input SFD file.
-//! \param [out] vFontChar vector holding glyph data.
-//! \returns SUCCESS if operation is successful.
-//! \returns FAIL if operation is not successful.
-//
-//! The glyphs are enclosed within [StartChar:] and [EndChar] sections. 
-//! Read the SFD file and load the following into FontChar vector:
-//! -# Name of the glyph as mentioned in the SFD file.
-//! -# Start position(?) of the glyph
-//! -# End position(?) of the glyph
-//! -# Code point value of the glyph
-//! -# Skip the glyph if it is not a Malayalam glyph
-//
-int analyzeSFDFile (char *inSfdName, vector<FontChar>& vFontChar)
-{
-	ifstream inSfdFile (inSfdName);
-	if (! inSfdFile.is_open ())
+	//! The fonts of a batch are already renamed in parallel, by default
+	//! only a single font is parsed on more than one thread.
+	opts.renameOpts.fontThreads = opts.fontThreads;
+	if (opts.fontThreads == 0)
 	{
-		jERR ("ERROR : Unable to open SFD file " << inSfdName);
-		return FAIL;
+		opts.renameOpts.fontThreads = ((jobs.size () == 1)
+			|| !opts.serveSocket.empty ()) ? thread::hardware_concurrency () : 1;
 	}
 
-	string glyphName; // Name of the glyph from SFD file
-	int dataFlag; // Indicate if the StartChar pattern is found
-	int startPos;
-	int codeValue;
-	string sfdData;
-	int retVal;
-
-	FontChar sfdFC;
-	jLOG ("Analyzing the SFD file");
-
-	Ligature sfdLigature; // Ligatures read from input SFD file.
-	vector<Ligature> vLigature;
-	//! Read the data from the input SFD file.
-	dataFlag = 0;
-	int lineNo = 0;
-	while (getline (inSfdFile, sfdData))
+	//! The reference data stays loaded, the fonts are renamed as the
+	//! clients ask for them.
+	if (!opts.serveSocket.empty ())
 	{
-		lineNo++;
-		//! Look for [StartChar:]
-		string srch (START_CHAR_TEXT);
-		size_t found;
-		found = sfdData.find (srch);
-		if (found != string::npos)
-		{
-			 jTRACE ("Rec# " << lineNo <<  " Processing ["
-			 		<< sfdData << "]");
-			dataFlag = 1;
-			//! [StartChar:] found, extract the glyph name which is
-			//! the 2nd token.
-			if (getTok (sfdData, glyphName, ' ', 2) != SUCCESS)
-			{
-				return FAIL;
-			}
-		}
-
-		//! Look for [Encoding:] 
-		srch = ENCODING_TEXT;
-		found = sfdData.find (srch);
-		if (found != string::npos)
-		{
-			jTRACE (setw(5) << "Rec# " <<lineNo <<  " Processing ["
-					<< sfdData << "]");
-			//! Check if StartChar is already found, if not skip.
-			if (0 == dataFlag)
+		RenameFunc renameFunc = [&vRefData, &renameMap, &opts]
+			(const string& inFile, const string& outFile,
+			const RenameOptions& options, RenameStats& stats)
 			{
-				jTRACE (setw (5) << "Rec# " << lineNo <<  " Skipping [" 
-					<< sfdData << "]");
-				continue;
-			}
-			//! [Encoding:] found, extract start, code point value, and end.
-			string tmpStr; 
-			 if (getTok (sfdData, tmpStr, ' ', 2) != SUCCESS)
-			 {
-			 	return FAIL;
-			 }
-			 else
-			 {
-			 	startPos = atoi (tmpStr.c_str ());
-			 }
-
-			 // Code point value at position 3
-			 if (getTok (sfdData, tmpStr, ' ', 3) != SUCCESS)
-			 {
-			 	return FAIL;
-			 }
-			 else
-			 {
-			 	if (tmpStr == "-1")
-				{
-					codeValue = -1;	
-				}
-				else
-				{
-					codeValue = atoi (tmpStr.c_str());
-				}
-			 }
-		}
-		
-		//! Look for Ligature
-		srch = LIGATURE_TEXT;
-		found = sfdData.find (srch);
-		if (found != string::npos)
-		{
-			 jTRACE ("Rec# " << lineNo <<  " Processing ["
-				<< sfdData << "]");
-			//! Split the data and store in Ligature class
-			retVal = storeLigature (sfdData, sfdLigature);
-			if (retVal != SUCCESS)
-			{
-				jERR ("Error : storeLigature [" << sfdData << "]");
-				continue;
-			}
-			jTRACE ("Rec# " << lineNo <<  " Storing Ligatures");
-			// sfdLigature.displayData ();
-
-			//! Add the ligature to the temp list.
-			vLigature.push_back (sfdLigature);
-
-			// Clear the sfdLigature data.
-			sfdLigature.clearGlypName ();
-			sfdLigature.setForm ("");
-		}
-
-		//! Look for EndChar
-		srch = END_CHAR_TEXT;
-		found = sfdData.find (srch);
-		if (found != string::npos)
-		{
-			jTRACE (setw(5) << "Rec# " << lineNo <<  " Processing ["
-				<< sfdData << "]");
-			
-			//! Save the glyph name into FontChar vector.
-			sfdFC.setCurName (glyphName);
-
-			//! Save the start pos into FontChar vector
-			sfdFC.setStartPos (startPos);
-
-			//! Save the code value into the FontChar vector
-			sfdFC.setUnicodeVal (codeValue);
+				return opts.applyMap.empty ()
+					? renameFont (vRefData, inFile, outFile, options, stats)
+					: applyRenameMap (renameMap, inFile, outFile, options, stats);
+			};
+		RenameServer server (renameFunc, opts.renameOpts);
+		unsigned int workerCount = (opts.jobs != 0) ? opts.jobs
+			: thread::hardware_concurrency ();
+		retVal = server.run (opts.serveSocket.c_str (), workerCount);
+		jlogFlush ();
+		return (retVal == SUCCESS) ? 0 : 2;
+	}
 
-			//! Save the ligatures to FontChar vector from the 
-			//! temporary Ligature list.
-			for (unsigned int i = 0; i < vLigature.size (); i++)
-			{
-				sfdFC.addLigature (vLigature[i]);
-			}
-			vFontChar.push_back (sfdFC);
-			jTRACE (setw(5) << "Rec# " << lineNo << " Added glyph info for " <<
-				glyphName << "]");
+	int failCount;
+	if (jobs.size () == 1)
+	{
+		jTRACE ("inFile = " << jobs[0].inFile);
+		jobs[0].result = renameJob (vRefData, renameMap, opts, jobs[0]);
+		failCount = (jobs[0].result == SUCCESS) ? 0 : 1;
+	}
+	else
+	{
+		failCount = renameBatch (vRefData, renameMap, opts, jobs);
+	}
 
-			sfdFC.displayData ();
+	if (!opts.statsFormat.empty ()
+		&& (reportStats (opts, refStats, jobs) != SUCCESS))
+	{
+		return (2);
+	}
 
-			vLigature.clear();
-			sfdFC.clearData ();
-		}
+	if (opts.memReport)
+	{
+		jlogFlush ();
+		ostream& out = opts.sfdToStdout ? cerr : cout;
+		out << "Heap use per phase" << endl;
+		memReportPrint (out);
 	}
-	jLOG ("Finished analyzing the SFD file");
-	inSfdFile.close ();
-	return SUCCESS;
+	return (failCount == 0) ? 0 : 2;
 }
 
-//! \fn int getTok (string inStr, string& out, char delim, int pos)
-//! \brief Copy the token at the pos from the string inStr delimited by
-//! delim to the string out.
-int getTok (string inStr, string& out, char delim, int pos)
+//! \fn int collectJobs (ProgOptions& opts, vector<FontJob>& jobs)
+//! \brief Get the fonts to rename from the -i/-o pairs and the manifest.
+//! stdin and stdout (STDIO_NAME) can be used by one font each, sfdToStdout
+//! is set if the output of a font goes to stdout.
+//! \param [in,out] opts Command line options.
+//! \param [out] jobs The fonts, in the order given.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the manifest cannot be read or stdin or stdout is used
+//! more than once.
+int collectJobs (ProgOptions& opts, vector<FontJob>& jobs)
 {
-	string tok;
-	stringstream s (inStr);
-
-	for (int i = 0; i < pos; i++)
+	for (unsigned int i = 0; i < opts.inFiles.size (); i++)
 	{
-		if (!getline (s, tok, delim))
-		{
-			return FAIL;
-		}
+		FontJob job;
+		job.inFile = opts.inFiles[i];
+		job.outFile = opts.outFiles[i];
+		jobs.push_back (job);
 	}
-	if (inStr == tok)
+
+	if (!opts.manifest.empty ()
+		&& (loadManifest (opts.manifest.c_str (), jobs) != SUCCESS))
 	{
-		// The delimiter was not present in the input string.	
 		return FAIL;
 	}
-	else
+
+	int stdinCount = 0;
+	int stdoutCount = 0;
+	for (unsigned int i = 0; i < jobs.size (); i++)
 	{
-		out = tok;
+		jobs[i].size = 0;
+		jobs[i].pos = i;
+		jobs[i].result = FAIL;
+		stdinCount += (jobs[i].inFile == STDIO_NAME) ? 1 : 0;
+		stdoutCount += (jobs[i].outFile == STDIO_NAME) ? 1 : 0;
 	}
 
-	return (SUCCESS);
-}
-//! \fn int storeLigature (string sfdData, Ligature& sfdLigature)
-//! \brief Populate the Ligature class from the Ligature Line read from
-//! the input SFD file
-//! \param [in] sfdData Ligature line from the input SFD file.
-//! \param [in] sfdLigature Ligature class to which the data will be loaded.
-//! \returns SUCCESS if data is stored successfully.
-//! \returns FAIL if operation fails.
-int storeLigature (string sfdData, Ligature& sfdLigature)
-{
-	//! Extract the form from the SFD line. Form will be enclosed in single
-	//! quotes. The form will be second token when the delimiter is
-	//! single quote.
-	
-	jTRACE ("Store Ligature");
-	string tmpStr;
-	int retVal;
-	retVal = getTok (sfdData, tmpStr, '\'', 2);
-	if (retVal != SUCCESS)
+	if ((stdinCount > 1) || (stdoutCount > 1))
 	{
+		jERR ("Only one font can be read from stdin or written to stdout");
 		return FAIL;
 	}
-	else
+	if ((stdoutCount > 0) && opts.renameOpts.useCache)
 	{
-		sfdLigature.setForm (tmpStr);
+		jERR ("The name cache needs an output file, -I cannot be used"
+			" with stdout");
+		return FAIL;
 	}
-	//! Extract the names of the glyphs from the end. The glyphs will be 
-	//! the third token if the delimiter is set to double quotes.
-	retVal = getTok (sfdData, tmpStr, '"', 3);
-	if (retVal != SUCCESS)
+	if ((jobs.size () > 1) && !opts.renameOpts.exportMap.empty ())
 	{
+		jERR ("The rename map is exported for a single font, --export-map"
+			" cannot be used with several fonts");
 		return FAIL;
 	}
+	opts.sfdToStdout = (stdoutCount > 0);
+	return SUCCESS;
+}
 
-	int i;
-	i = 1;
-	string glyphName;
-	while (1)
+//! \fn int renameJob (const RefTable& vRefData, const RenameMap& renameMap, ProgOptions& opts, FontJob& job)
+//! \brief Rename one font, using the rename map with -A.
+//! \param [in] vRefData Reference data, not used with -A.
+//! \param [in] renameMap Rename map loaded with -A.
+//! \param [in] opts Command line options.
+//! \param [in,out] job The font, the statistics are filled in.
+//! \returns SUCCESS if the font is renamed.
+//! \returns FAIL if operation is not successful.
+int renameJob (const RefTable& vRefData, const RenameMap& renameMap,
+	ProgOptions& opts, FontJob& job)
+{
+	if (!opts.applyMap.empty ())
 	{
-		retVal = getTok (tmpStr, glyphName, ' ', i);
-		i++;
-		if (retVal != SUCCESS)
-		{
-			//! getTok will return FAIL when it encounter the end of the
-			//! string. At this moment, it cannot be determined whether
-			//! getTok encountered an error or end of the string.
-			return SUCCESS;
-		}
-		else
-		{
-			if (glyphName.length () == 0)
-			{
-				// Ignore the spaces.
-				continue;
-			}
-			sfdLigature.addGlypToList (glyphName);
-		}
+		return applyRenameMap (renameMap, job.inFile, job.outFile,
+			opts.renameOpts, job.stats);
 	}
-
-	return SUCCESS;
+	return renameFont (vRefData, job.inFile, job.outFile, opts.renameOpts,
+		job.stats);
 }
 
-//! \fn int renameGlyphs (map<int, CharRefData> vRefData, vector <FontChar>& vFontChar, map<string, string>& nameMap, int& renCount)
-//! \brief Traverse through the glyph info and identify the glyphs
-//! that need to be renamed.
-//!	\param [in] vRefData Map containing reference data
-//! \param [in] vFontChar Vector holding SFD glyph data
-//! \param [in] nameMap map holding key value pair of old and new glyph names.
-//! \param [out] renCount Number of renames performed
-//! \returns SUCCESS if operation is successful
-//! \returns FAIL if operation is not successful
-//!
-//! Rules of the game:
-//!
-//! -# Glyphs will be renamed as specified in the reference file.
-//! -# Composite glyphs will be renamed based on the constituent ligatures.
-//! The name of the constituent glyphs will be combined to form the new name
-//! of the composite glyph.
-//! -# If there are multiple ligatures for a composite glyph, the one
-//! with akhn will be used.
-//! -# In case of a tie, the ligature with maximum glyphs will be used
-//! for the creation of the new name
-//! -# When two or more glyphs are joined to form new glyph name, the Conjunct
-//! symbols are ignored to keep the name short and readable.
-//! -# If the derived new name is already used in the SFD file, an underscore
-//! followed by a sequence number will be appended to the new name to
-//! avoid conflicts.
-//! -# Certain glyphs need special processing and they are renamed to 
-//! pre defined names. Refer processHalfForms () for details on such glyphs.
-int renameGlyphs (map<int, CharRefData> vRefData,
-	vector <FontChar>& vFontChar, map<string, string>& nameMap, int& renCount)
+//! \fn int renameBatch (const RefTable& vRefData, const RenameMap& renameMap, ProgOptions& opts, vector<FontJob>& jobs)
+//! \brief Rename the fonts given by -i/-o pairs and the manifest.
+//! The fonts are renamed in parallel on opts.jobs threads, the largest
+//! input files are started first so that a big font does not finish
+//! last, alone.
+//! \param [in] vRefData Reference data, shared by all the fonts.
+//! \param [in] renameMap Rename map loaded with -A, shared by all the fonts.
+//! \param [in] opts Command line options.
+//! \param [in,out] jobs The fonts, the result and statistics are filled in.
+//! They are left in the order given.
+//! \returns The number of fonts that could not be renamed.
+int renameBatch (const RefTable& vRefData, const RenameMap& renameMap,
+	ProgOptions& opts, vector<FontJob>& jobs)
 {
-
-	unsigned int i;
-
-	string fcName;
-	string refName;
-
-	//! Rename the characters. Since the Map and reference data are
-	//! not directly connected, have to use the data loaded from
-	//! the SFD file.
-
-	// renCount might contain value from previous run, set it to 0,
-	renCount = 0;
-	jLOG ("renameGlyphs() : Renaming the Glyphs");
-	
-	jLOG ("renameGlyphs() : Processing base characters");
-	for (i = 0; i < vFontChar.size (); i++)
+	for (unsigned int i = 0; i < jobs.size (); i++)
 	{
-		int fcUniVal;
-		fcUniVal = vFontChar[i].getUnicodeVal();
-		fcName = vFontChar[i].getCurName();
-		if (fcUniVal == -1)
-		{
-			//! Ignore composite characters while renaming base characters.
-			continue;
-		}
-
-		refName = vRefData[fcUniVal].getCharName ();
-
-		// Name of character from SFD file and corresponding name from
-		// ref file.
-		nameMap[fcName] = refName;
-
-		// Set the new name in the FontChar.
-		vFontChar[i].setNewName (refName);
-		jLOG ("Base char " << "old [" << fcName <<
-					"] new [" << refName << "]");
+		struct stat st;
+		jobs[i].size = (stat (jobs[i].inFile.c_str (), &st) == 0) ? st.st_size : 0;
 	}
+	stable_sort (jobs.begin (), jobs.end (),
+		[] (const FontJob& a, const FontJob& b) {return a.size > b.size;});
 
-	for (map <string, string>::iterator i = nameMap.begin ();
-			i != nameMap.end(); ++i)
+	unsigned int workerCount = opts.jobs;
+	if (workerCount == 0)
 	{
-		if ((*i).second == CONJUNCT)
-		{
-			Conjunct = (*i).first;
-			jTRACE ("Conjunct [" << Conjunct << "]");
-		}
+		workerCount = thread::hardware_concurrency ();
+	}
+	if (workerCount > jobs.size ())
+	{
+		workerCount = jobs.size ();
+	}
+	jLOG ("Renaming " << jobs.size () << " font(s) using "
+		<< workerCount << " thread(s)");
 
-		if ((*i).second == ZWJ)
+	{
+		ThreadPool pool (workerCount);
+		for (unsigned int i = 0; i < jobs.size (); i++)
 		{
-			Zwj = (*i).first;
-			jTRACE ("Zwj [" << Zwj << "]");
+			FontJob *job = &jobs[i];
+			pool.submit ([&vRefData, &renameMap, &opts, job] ()
+				{
+					jLOG ("Renaming " << job->inFile << " to " << job->outFile);
+					job->result = renameJob (vRefData, renameMap, opts, *job);
+				});
 		}
+		pool.wait ();
 	}
 
-	jLOG ("renameGlyphs() : Finished processing base characters");
-	showMap (nameMap);
-
-	//! Traverse through the glyphs in the FontChar vector and see if 
-	//! any glyphs can be renamed with the available data in Rename map.
-	
-	jLOG ("renameGlyphs() : Processing the glyphs");
-	for (unsigned int i = 0; i < vFontChar.size (); i++)
+	int failCount = 0;
+	for (unsigned int i = 0; i < jobs.size (); i++)
 	{
-		string tCurName = vFontChar[i].getCurName ();
-		string tNewName = nameMap[tCurName];
-		if (tNewName.length() != 0)
+		if (jobs[i].result != SUCCESS)
 		{
-			jTRACE ("New name found for " << tCurName << ": "
-					<< tNewName);
-			// Set the new name in the FontChar.
-			vFontChar[i].setNewName (tNewName);
+			jERR ("Unable to rename " << jobs[i].inFile);
+			failCount++;
 		}
 	}
-	jLOG ("renameGlyphs() : Finished processing the glyphs");
-
-	jLOG ("renameGlyphs() : Processing the Ligatures");
-
-	//! Traverse through the glyphs of the Ligatures in the FontChar vector
-	//! and see if any of FontChar glyphs can be renamed.
-	for (unsigned int i = 0; i < vFontChar.size (); i++)
-	{
-		string curName;
-		string newName;
-		vector<string> nameComps;
-		vector<string> akhnComps;
-		vector<string> maxComps;
-		vector<string> finalComps;
+	jLOG ("Renamed " << jobs.size () - failCount << " of " << jobs.size ()
+		<< " font(s)");
 
-		int maxCount; // Maximum glyphs in a ligature
-		int copyToMax;
-		int akhnFlag; // Indicate if akhn form is found
-
-		int renFlag; // Indicate if the glyph can be renamed.
-
-		curName = vFontChar[i].getCurName ();
-		int LigatureCount = vFontChar[i].getLigatureCount ();
-		maxCount = 0;
-		copyToMax = 0;
-		akhnFlag = 0;
-		renFlag = 0;
-
-		// Clear the vectors holding the glyph names.
-		nameComps.clear ();
-		akhnComps.clear ();
-		maxComps.clear ();
-		newName.clear ();
+	sort (jobs.begin (), jobs.end (),
+		[] (const FontJob& a, const FontJob& b) {return a.pos < b.pos;});
+	return failCount;
+}
 
-		jTRACE ("\n");
-		jTRACE ("renameGlyphs() : Processing Ligature : " << curName); 
+//! \fn int reportStats (ProgOptions& opts, PhaseStats& refStats, vector<FontJob>& jobs)
+//! \brief Write the statistics of the run, as a table or JSON.
+//! The queued log messages are written first, so that the report is not
+//! mixed with them when both go to stdout.
+//! \param [in] opts Command line options.
+//! \param [in] refStats Statistics of loading the reference file.
+//! \param [in] jobs The fonts, in the order given.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the statistics file cannot be written.
+int reportStats (ProgOptions& opts, PhaseStats& refStats, vector<FontJob>& jobs)
+{
+	jlogFlush ();
 
-		if (LigatureCount == 0)
+	ofstream statsFile;
+	if (!opts.statsFile.empty ())
+	{
+		statsFile.open (opts.statsFile);
+		if (! statsFile.is_open ())
 		{
-			// No ligatures, skip.
-			continue;
+			jERR ("Unable to open statistics file " << opts.statsFile);
+			return FAIL;
 		}
+	}
+	ostream& out = !opts.statsFile.empty () ? statsFile
+		: (opts.sfdToStdout ? cerr : cout);
+	const string& refFile = opts.applyMap.empty () ? opts.refFile
+		: opts.applyMap;
 
-		// Check in the nameMap to see if it is already renamed.
-		newName = nameMap[curName];
-		if (newName.length() > 0)
+	if (opts.statsFormat == "json")
+	{
+		printRefStatsJson (out, refFile, refStats);
+		for (unsigned int i = 0; i < jobs.size (); i++)
 		{
-			// New name available, skip this.
-			jTRACE ("[" << curName << "] already renamed to [" << newName << "]");
-			continue;
+			printStatsJson (out, jobs[i].inFile, jobs[i].outFile,
+				jobs[i].result, jobs[i].stats, (i == 0));
 		}
-
-		for (int l = 0; l < LigatureCount; l++)
-		{
-			Ligature& tLig  = vFontChar[i].getLigature (l);
-			// If the index out of range, getLigature will return a object
-			// with form set to InvalidObject. If that is the case free the
-			// object and return FAIL.
-			if (curName == "InvalidObject")
-			{
-				jERR ("getLigature at " << l << " failed.");
-				delete &tLig;
-				return (FAIL);
-			}
-
-			string tForm;
-			tForm = tLig.getForm ();
-			jTRACE ("Processing form [" << tForm << "]");
-
-			// Check if all the glyphs are renamed.
-			unsigned int glyphCount = tLig.getGlypListSize ();
-			int newCount;
-			newCount = 0;
-
-			if ((int) glyphCount > maxCount)
-			{
-				maxCount = glyphCount;
-				// This Ligature has got max glyphs so far, set copyToMax flag
-				// so that the glyphs will be copied to maxComps.
-				copyToMax = 1;
-
-				// maxComps may contain data from the previous Ligature,
-				// clear it.
-				maxComps.clear ();
-			}
-			else
-			{
-				copyToMax = 0;
-			}
-
-			if ("akhn" == tForm)
-			{
-				jTRACE ("Setting akhn flag ");
-				akhnFlag = 1;
-				akhnComps.clear ();
-			}
-			else
-			{
-				akhnFlag = 0;
-			}
-
-			// Clear the data from the previous ligature.
-			nameComps.clear ();
-
-			for (unsigned int k = 0; k < glyphCount; k++)
-			{
-				string tGlyphName;
-				string tNewName;
-				tLig.getNthglyphName (k, tGlyphName);
-				jDBG (k << " : " << tGlyphName);
-				nameComps.push_back (tGlyphName);
-
-				if (copyToMax)
-				{
-					// Max # of glyphs, save it for later use.
-					maxComps.push_back (tGlyphName);
-				}
-				jTRACE ("tForm: " << tForm);
-				if (akhnFlag)
-				{
-					jTRACE ("Adding [" << tGlyphName << "] to akhnComps");
-					akhnComps.push_back (tGlyphName);
-				}
-
-				// Check if the glyph name has got new name in the map.
-				tNewName = nameMap[tGlyphName];
-				if (tNewName.length () != 0)
-				{
-					newCount++;
-				}
-				jTRACE ("[" << tGlyphName << "] [" << tNewName << "]");
-			}
-
-			if (newCount == (int) glyphCount)
-			{
-				// All the constituent glyphs have new names, can be renamed.
-				jDBG (curName << " Can be renamed");
-				renFlag++;
-			}
-			else
-			{
-				jDBG (curName << " Cannot be renamed");
-				continue;
-			}
-		}
-
-
-		int dupRet;
-		if ((LigatureCount == 1) && (renFlag == LigatureCount))
+		printStatsJsonEnd (out);
+	}
+	else
+	{
+		printRefStatsText (out, refFile, refStats);
+		for (unsigned int i = 0; i < jobs.size (); i++)
 		{
-			// Only one form, straight away rename.
-			jDBG ("Straight rename");
-			finalComps = nameComps;
+			printStatsText (out, jobs[i].inFile, jobs[i].result, jobs[i].stats);
 		}
-		else
-		{
-			if (renFlag != LigatureCount)
-			{
-				// At least one of the ligature had a glyph without new name.
-				// Skip the renaming
-				jDBG ("RenFlag check failed for " << curName);
-				continue;
-			}
-
-			jDBG ("Multiple ligatures, further processing required");
-			if (akhnFlag)
-			{
-				jDBG ("Multiple ligatures, akhn form being added");
-				finalComps = akhnComps;
-			}else
-			{
-				jDBG ("Multiple ligatures, max being added");
-				finalComps = maxComps;
-			}
-		}
-
-		string suffix;
-		int seq;
-		string base;
-		seq = 0;
-		buildName (nameMap, finalComps, newName);
-		base = newName; // Base name, required in case of duplicates.
-		base.append ("_");
-		do
-		{
-			jTRACE ("Calling checkDups");
-			jTRACE ("Current glyph is [" << curName << "]");
-			dupRet = checkDups (vFontChar, i, newName);
-			if (dupRet == FAIL)
-			{
-				// Special processing required for some half forms.
-				int retVal;
-
-				string hName;
-				retVal = processHalfForms (curName, newName, hName);
-				if (retVal == SUCCESS)
-				{
-					// It was one of those cases that required special processing.
-					newName = hName;
-
-					dupRet = SUCCESS; // Break out of the checkDups loop.
-				}
-				else
-				{
-					jLOG ("[" << newName
-						<< "] already taken, appending seq #");
-					seq ++;
-					stringstream ss;
-					ss << seq;
-					suffix = ss.str();
-
-					jTRACE ("Suffix [" << suffix << "]");
-					newName = base;
-					newName.append (suffix);
-				}
-			}
-		} while (dupRet == FAIL);
-		jDBG ("Adding [" << curName << "] and [" << newName <<
-				"]to the map");
-		nameMap[curName] = newName;
-		
-		// Set the new name.
-		vFontChar[i].setNewName (newName);
-		renCount++;
 	}
-	jLOG ("renameGlyphs() : Finished processing the Ligatures");
-	showMap (nameMap);
+	out.flush ();
 
-	/*
-	for (i = 0; i < vFontChar.size (); i++)
+	if (statsFile.is_open ())
 	{
-		vFontChar[i].displayData ();
-		vFontChar[i].displayGlyphs ();
+		statsFile.close ();
+		if (statsFile.fail ())
+		{
+			jERR ("Error writing statistics file " << opts.statsFile);
+			return FAIL;
+		}
 	}
-	*/
-
 	return SUCCESS;
 }
 
-
-//! \fn void showMap (map<string, string> nameMap)
-//! \brief Display the contents of the Rename map
-void showMap (map<string, string> nameMap)
+//! \fn int loadManifest (const char *manifest, vector<FontJob>& jobs)
+//! \brief Read the input and output SFD files from the manifest.
+//! Every line of the manifest holds an input and output file name
+//! separated by white space. Empty lines and lines starting with # are
+//! ignored.
+//! \param [in] manifest Name of the manifest file.
+//! \param [in,out] jobs The fonts are appended to jobs.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be read or a line is not valid.
+int loadManifest (const char *manifest, vector<FontJob>& jobs)
 {
-	jTRACE ("showMap ()");
-	for (map <string, string>::iterator i = nameMap.begin ();
-			i != nameMap.end(); ++i)
+	ifstream mFile (manifest);
+	if (! mFile.is_open ())
 	{
-		jTRACE ((*i).first << ":" << (*i).second);
-	}
-}
-
-//! \fn int buildName (map<string, string> nameMap, vector<string> comps, string& out)
-//! \brief Build the new name for a glyph.
-//! The new names of the strings are looked up against the Rename map and
-//! creates new name.
-//! \param [in] nameMap The rename map from which the new names will be
-//! looked up
-//! \param [in] comps Vector containing the glyphs to be renamed.
-//! \param [out] out The string that will hold the new name.
-//!
-//! -# If the strings are glyph + xx + zwj, it is considered as a chillu
-//! and new new name will be glyph + "cil"
-int buildName (map<string, string> nameMap, vector<string> comps, string& out)
-{
-	unsigned int i;
-	int zFlag;
-	int cFlag;
-	string newName;
-	string mappedName; // Currently mapped name for the glyph
-
-	cFlag = 0;
-	zFlag = 0;
-	newName = "";
-
-	for (i = 0; i < comps.size (); i++)
-	{
-		jTRACE ("i = " << i << " " << comps[i]);
+		jERR ("Unable to open manifest " << manifest);
+		return FAIL;
 	}
 
-	for (i = 0; i < comps.size(); i++)
+	string line;
+	int lineNo = 0;
+	while (getline (mFile, line))
 	{
-		jDBG ("Finding new name for " << comps[i]);
-		// Check for Chillu & ZWJ
-		// if (comps[i] == ZWJ) 
-		if ((comps[i] == ZWJ) || (comps[i] == Zwj))
-		{
-			zFlag++;
-
-			jTRACE ("Found ZWJ case");
-			//! Check if this is a chillu - glyph + xx + zwj. If true, rename
-			//! glyph to glyph + chil
-
-			if ( (i == 2) && (cFlag == 1) && (comps.size() == 3))
-			{
-				jDBG ("Found chillu comibination for " << comps[0]);
-				// out = comps[0];
-				out.append (CHILLU_NANE);
-			}
-			continue;
-		}
-
-		/*
-		jTRACE ("Conjunct [" << Conjunct << "]");
-		if ((comps[i] == "CONJUNCT") || (comps[i] == Conjunct))
-		{
-			//! If there are only two glyphs and the 2nd one is xx, retain it.
-			jTRACE ("Found Conjunct case");
-			cFlag++;
-
-			jTRACE ("out, before appening virama [" << out << "]");
-			if ( (i == 1) && (comps.size() == 2))
-			{
-				// out = comps[0];
-				out.append (CONJUNCT);
-			}
-			jTRACE ("Appended Conjunct, now the name is [" << out);
-			continue;
-		}
-		*/
+		lineNo++;
+		istringstream fields (line);
+		FontJob job;
+		string extra;
 
-		if ((comps[i] == "CONJUNCT") || (comps[i] == Conjunct))
+		if (!(fields >> job.inFile) || (job.inFile[0] == '#'))
 		{
-			// Skip Conjunct.
-			cFlag++;
-			jTRACE ("Skipping Conjunct");
 			continue;
 		}
-
-		mappedName = nameMap[(comps[i])];
-		if (mappedName.length() != 0)
-		{
-			if (mappedName == CONJUNCT)
-			{
-				// Conjunct, skip it.
-				continue;
-			}
-
-			jDBG ("Named map [" << comps[i]
-					<< "] [" << mappedName << "]");
-			newName.append (mappedName);
-
-			jDBG ("New Name : [" << newName << "]");
-			out = newName;
-		}
-		else
+		if (!(fields >> job.outFile) || (fields >> extra))
 		{
-			// Not found in the remap, use the old one itself.
-			newName.append (comps[i]);
-			jDBG ("New Name : [" << newName << "]");
-			out = newName;
+			jERR (manifest << ":" << lineNo
+				<< " : Expected input and output SFD file names");
+			return FAIL;
 		}
+		jobs.push_back (job);
 	}
-
-	return (SUCCESS);
+	return SUCCESS;
 }
 
-
-//! \fn int writeNewSFD (char *inSfdName, char *outFname, vector <FontChar>& vFontChar, map<string, string> nameMap)
-//! \brief Read the input SFD file and create new SFD file with new glyph names.
-//!
-//! Read the input SFD file and and rename the glyphs using the look up table.
-//! \param [in] inSfdName Name of the input SFD file.
-//! \param [in] outFname Name of the output SFD file.
-//! \param [in] vFontChar FontChar vector
-//! \param [in] nameMap The lookup table for new glyph names.
-int writeNewSFD (char *inSfdName, char *outFname, vector <FontChar>& vFontChar, map<string, string> nameMap)
+//! \fn int compileReference (const char *refFile)
+//! \brief Write the binary cache of the reference file.
+//! The cache is written next to the reference file, with REF_CACHE_EXT
+//! appended to the name. Later runs map it instead of parsing the file.
+//! \param [in] refFile Name of the file containing reference data.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if operation is not successful.
+int compileReference (const char *refFile)
 {
-	string sfdData; // Data read from the input SFD file.
-	string srchPattern; // Search pattern
-
-	ifstream inSfdFile (inSfdName);
-	size_t strPos;
-
-	jLOG ("Writing new SFD file");
-
-	if (! inSfdFile.is_open ())
+	RefTable ref;
+	if (ref.loadText (refFile) != SUCCESS)
 	{
-		jERR ("Error : Unable to open SFD file " << inSfdName);
-		return FAIL;
+		jERR ("Error : Unable to load reference file " << refFile);
+		return (FAIL);
 	}
 
-	ofstream outFile (outFname);
-	if (! outFile.is_open ())
+	string cacheFile = string (refFile) + REF_CACHE_EXT;
+	if (ref.writeCache (cacheFile.c_str ()) != SUCCESS)
 	{
-		jERR ("Uanble to open output file " <<  outFname);
+		return (FAIL);
 	}
+	jLOG ("Wrote " << ref.getCount () << " code points to " << cacheFile);
+	return (SUCCESS);
+}
 
-	while (getline (inSfdFile, sfdData))
-	{
-		srchPattern = START_CHAR_TEXT;
-		strPos = sfdData.find (srchPattern);
+//! \fn int verifyFiles (ProgOptions& opts)
+//! \brief Check the pairs of input and output SFD files given with -V and
+//! print the result of each pair.
+//! \param [in] opts Command line options.
+//! \returns The number of pairs that do not match.
+int verifyFiles (ProgOptions& opts)
+{
+	unsigned int threads = (opts.fontThreads != 0) ? opts.fontThreads
+		: thread::hardware_concurrency ();
+	int failCount = 0;
 
-		if (strPos != string::npos)
+	for (unsigned int i = 0; i + 1 < opts.verifyFiles.size (); i += 2)
+	{
+		const string& inFile = opts.verifyFiles[i];
+		const string& outFile = opts.verifyFiles[i + 1];
+		SfdVerifier verifier;
+		int retVal = verifier.verify (inFile, outFile, threads);
+		jlogFlush ();
+		if (retVal == SUCCESS)
 		{
-			replaceFCName (nameMap, sfdData);
+			cout << outFile << " : OK, " << verifier.getGlyphCount ()
+				<< " glyph(s), " << verifier.getRenamedCount () << " renamed, "
+				<< verifier.getNameCount () << " name(s) compared" << endl;
 		}
-
-		srchPattern = LIGATURE_TEXT;
-		strPos = sfdData.find (srchPattern);
-		if (strPos != string::npos)
+		else
 		{
-			replaceGlyphNames (nameMap, sfdData);
+			cout << outFile << " : FAILED, " << verifier.getMismatchCount ()
+				<< " mismatch(es) against " << inFile << endl;
+			failCount++;
 		}
-		outFile << sfdData << "\n";
 	}
-	jLOG ("Finished Writing new SFD file");
-
-	return SUCCESS;
+	return failCount;
 }
 
-//! \fn int replaceFCName (map <string, string> nameMap, string& sfdData)
-//! \brief Replace the name of the StartChar.
-//! Replace the glyph name in the StartChar section using the look up data
-//! from the map. If the new name is not found, keep the old one.
-//! \param [in] nameMap Look up data for renaming
-//! \param [out] sfdData Line from SFD file
-int replaceFCName (map <string, string> nameMap, string& sfdData)
+//! \fn int corpusReport (ProgOptions& opts)
+//! \brief Compare the glyph names of the fonts given with -C with those of
+//! the reference font, the first file, and write the report. The files
+//! are read in parallel, -j of them at a time.
+//! \param [in] opts Command line options.
+//! \returns SUCCESS if all the files were read and the report written.
+//! \returns FAIL if operation is not successful.
+int corpusReport (ProgOptions& opts)
 {
-	string glyphName;
-	string newName; // New name of the glyph
-	size_t strPos;
-
-	if (getTok (sfdData, glyphName, ' ', 2) == SUCCESS)
-	{
-		jTRACE ("Found start char [" << sfdData << "], glyph name ["
-			<< glyphName << "]");
-
-		// Check if the new name for glyph name is available
-		// in the Rename map.
-		newName = nameMap[glyphName];
-		if ((newName.length () != 0 ) && (newName != glyphName))
-		{
-			// Proceed only if the new name is different
-			jTRACE ("Found new name for [" << glyphName <<
-				"] = [" << newName << "]");
-			strPos = sfdData.find (glyphName);
-			if (strPos != string::npos)
-			{
-				jTRACE ("Glyph " <<  glyphName << " is at " << strPos);
-				sfdData.replace (strPos, glyphName.length (), newName);
-				jTRACE ("Replaced [" << sfdData << "]");
-			}
+	unsigned int threads = (opts.jobs != 0) ? opts.jobs
+		: thread::hardware_concurrency ();
+	vector<string> fontFiles (opts.corpusFiles.begin () + 1,
+		opts.corpusFiles.end ());
+	CorpusStats corpus;
+	int retVal = corpus.compare (opts.corpusFiles[0], fontFiles, threads,
+		opts.listNames);
+	jlogFlush ();
+
+	ofstream reportFile;
+	if (!opts.statsFile.empty ())
+	{
+		reportFile.open (opts.statsFile);
+		if (! reportFile.is_open ())
+		{
+			jERR ("Unable to open statistics file " << opts.statsFile);
+			return FAIL;
 		}
 	}
-	return SUCCESS;
-}
-
-//! \fn int replaceGlyphNames (map<string, string> nameMap, string& sfdData)
-//! \brief Replaces the glyph names in the Ligature line with the new names.
-//! \param [in] nameMap Look up data for renaming
-//! \param [out] sfdData Line from SFD file
-//!
-//! Replace the glyph names in the Ligature line based on the data from the
-//! look up table. The glyphs are renamed individually to prevent any
-//! incorrect partial renames.
-int replaceGlyphNames (map<string, string> nameMap, string& sfdData)
-{
-	string glyphNames;
-	string oldGlyphNames;
-	size_t gPos;
-	size_t nextPos;
-	jTRACE ("\n");
-
-	if (getTok (sfdData, glyphNames, '"', 3) == SUCCESS)
+	ostream& out = !opts.statsFile.empty () ? reportFile : cout;
+	if (opts.statsFormat == "json")
 	{
-		jTRACE ("Found glyphs [" << glyphNames << "]");
-		oldGlyphNames = glyphNames;
+		corpus.printJson (out);
 	}
 	else
 	{
-		return FAIL;
-	}
-
-	map<string, string> glyphComps;
-
-	string t;
-	int i = 1;
-	//! Store the glyph names in the map. The map is used so that only
-	//! unique values will be stored.
-	while (getTok (glyphNames, t, ' ', i) == SUCCESS)
-	{
-		if (t.length() != 0)
-		{
-			glyphComps[t] = t;
-		}
-		i++;
+		corpus.printText (out);
 	}
 
-	for (map<string, string>::iterator m = glyphComps.begin();
-			m != glyphComps.end(); ++m)
+	if (reportFile.is_open ())
 	{
-		//! Look for the glyphs in the input string.
-		
-		gPos = 0;
-		nextPos = 0;
-		string oldName = (*m).first;
-		string newName;
-		while (1)
+		reportFile.close ();
+		if (reportFile.fail ())
 		{
-			// Look for the glyph name in the string.
-			gPos = glyphNames.find (oldName, nextPos);
-			if (gPos != string::npos)
-			{
-				// Found the glyph in the string, replace it.
-				//! Set the start point for the next search just beyond the
-				//! end of the glyph.
-				nextPos = gPos + oldName.length();
-				newName = nameMap[oldName];
-				if (newName.length() == 0)
-				{
-					//! If glyph does not have new name, skip it.
-					// newName = oldName;
-					continue;
-				}
-
-				//! Make sure that the match is not a partial match (k1 is
-				//! matched with k1 and not with xxk1 or k1xx).
-			
-				char prev;
-				char next;
-				// If the previous char is not space, it is a partial match.
-				if (gPos != 0)
-				{
-					// Not at the beginning of the string.
-					prev = glyphNames.at(gPos - 1);	
-					if (prev != ' ')
-					{
-						// Partial match
-						continue;
-					}
-
-					if (gPos + oldName.length () < glyphNames.length ())
-					{
-						next = glyphNames.at(gPos + oldName.length());
-						if (next != ' ')
-						{
-							// Partial match
-							continue;
-						}
-					}
-				}
-			
-				glyphNames.replace (gPos, oldName.length (), newName);
-			}
-			else
-			{
-				break;
-			}
+			jERR ("Error writing statistics file " << opts.statsFile);
+			return FAIL;
 		}
 	}
-	//! Replace the glyphs part in the input string with the new names.
-	jTRACE ("sfd [" << sfdData << "] glyphNames [" << oldGlyphNames << "]");
-	gPos = sfdData.find (oldGlyphNames, 0);
-	if (gPos != string::npos)
-	{
-		sfdData.replace (gPos, oldGlyphNames.length (), glyphNames);
-	}
-	
-	jTRACE ("New [" << sfdData << "]");
-
-	return SUCCESS;
+	return retVal;
 }
 
 //! \fn void help (char *progName)
@@ -1180,29 +640,76 @@ void help (char *progName)
 	cout << "\t -r Reference File" << endl;
 	cout << "\t -i Input SFD File" << endl;
 	cout << "\t -o Output SFD File" << endl;
+	cout << "\t    -i and -o can be repeated to rename several fonts" << endl;
+	cout << "\t    - reads the input SFD from stdin, writes the output to stdout"
+		<< endl;
+	cout << "\t [-m Manifest] File with input and output SFD file names,"
+		" a pair per line" << endl;
+	cout << "\t [-j Jobs] Number of fonts renamed in parallel" << endl;
+	cout << "\t [-c | --compile-ref] Write the binary cache of the reference"
+		" file and exit" << endl;
+	cout << "\t [-s text | json] Report the time and counters of each phase"
+		<< endl;
+	cout << "\t [-S Stats File] Write the report to the file" << endl;
+	cout << "\t [-M | --mem-report] Report the heap use of each phase" << endl;
+	cout << "\t [-I | --incremental] Rename only the glyphs changed since"
+		<< " the previous run" << endl;
+	cout << "\t [-X | --strict] Fail a font with duplicate glyph names in"
+		<< " the input or the output" << endl;
+	cout << "\t [-p Threads] Number of threads parsing each SFD file" << endl;
+	cout << "\t [-E | --export-map Map File] Write the old and new glyph"
+		" names to the map" << endl;
+	cout << "\t [-A | --apply-map Map File] Rename the glyphs of SFD or text"
+		" files using the map, -r is not needed" << endl;
+	cout << "\t [-D | --serve Socket] Stay resident and rename the fonts"
+		" requested over the Unix socket" << endl;
+	cout << "\t [-V | --verify inputSFD outputSFD ...] Check that the output"
+		" SFD files are renames of the input ones, -r is not needed" << endl;
+	cout << "\t [-C | --corpus-stats referenceSFD SFD ...] Compare the glyph"
+		" names of the SFD files with the reference font, -s and -S select"
+		" the format and the file of the report" << endl;
+	cout << "\t [-N | --list-names] List the glyph names only one of the"
+		" fonts has, with -C" << endl;
 	cout << "\t [-l DBG | TRACE ] " << endl;
+	cout << "\t [-L Log File] Write the log messages to the file" << endl;
 	cout << "\t -h Display this help message" << endl;
 
 }
 
-//! \fn int processArgs (int argc, char **argv, char *inFile, char *outFile, char *refFile, string& lvl)
+//! \fn int processArgs (int argc, char **argv, ProgOptions& opts)
 //! \brief Process and validate the input arguments and parameters.
 //! Process and validate the input arguments and parameters. The program
-//! expects three mandatory parameters - -i, -o and -r.
+//! expects the reference file (-r), or a rename map (-A), and at least one
+//! pair of input (-i) and output (-o) files, or a manifest (-m), unless
+//! it serves the fonts over a socket (-D), verifies files (-V) or compares
+//! them (-C).
 //! \param [in] argc argc from main().
 //! \param [in] argv argv from main().
-//! \param [out] inFile Name of the input SFD file.
-//! \param [out] outFile Name of the output SFD file.
-//! \param [in] refFile Name of the Reference file.
-//! \param [out] lvl The log level (DBG, TRACE).
-int processArgs (int argc, char **argv, char *inFile, char *outFile, char *refFile, string& lvl)
+//! \param [out] opts The options.
+int processArgs (int argc, char **argv, ProgOptions& opts)
 {
 	static struct option glyphOptions[] = 
 	{
 		{"insfd",		required_argument,	0, 'i'},
 		{"outsfd",		required_argument,	0, 'o'},
 		{"refnam",		required_argument,	0, 'r'},
+		{"manifest",	required_argument,	0, 'm'},
+		{"jobs",		required_argument,	0, 'j'},
+		{"compile-ref",	no_argument,		0, 'c'},
+		{"stats",		required_argument,	0, 's'},
+		{"stats-file",	required_argument,	0, 'S'},
+		{"mem-report",	no_argument,		0, 'M'},
+		{"incremental",	no_argument,		0, 'I'},
+		{"strict",		no_argument,		0, 'X'},
+		{"threads",	required_argument,	0, 'p'},
+		{"export-map",	required_argument,	0, 'E'},
+		{"apply-map",	required_argument,	0, 'A'},
+		{"serve",		required_argument,	0, 'D'},
+		{"verify",		no_argument,		0, 'V'},
+		{"corpus-stats",	no_argument,		0, 'C'},
+		{"list-names",	no_argument,		0, 'N'},
 		{"log",			required_argument,	0, 'l'},
+		{"logfile",		required_argument,	0, 'L'},
 		{"help",		no_argument, 		0, 'h'},
 		{0,				0,					0, 0}
 	};
@@ -1210,10 +717,14 @@ int processArgs (int argc, char **argv, char *inFile, char *outFile, char *refFi
 	int helpFlag = 0;
 	int c = 0;
 	int optIdx = 0;
+	int jobs;
+	int threads;
+	bool verify = false;
+	bool corpus = false;
 
 	while (1)
 	{
-		c = getopt_long (argc, argv, "i:o:r:l:h", glyphOptions, &optIdx);
+		c = getopt_long (argc, argv, "i:o:r:m:j:cs:S:MIXp:E:A:D:VCNl:L:h", glyphOptions, &optIdx);
 		jDBG ("optIdx " << optIdx);
 		if ( -1 == c )
 		{
@@ -1229,24 +740,113 @@ int processArgs (int argc, char **argv, char *inFile, char *outFile, char *refFi
 			case 'i' :
 				jDBG ("i: name " << glyphOptions[optIdx].name
 						<<" optarg "<< optarg);
-				strcpy (inFile, optarg);
-				// jDBG ("inFile " << inFile);
+				opts.inFiles.push_back (optarg);
 				break;
 			case 'o' :
 				jDBG ("o: name " << glyphOptions[optIdx].name
 						<<" optarg "<< optarg);
-				strcpy (outFile, optarg);
+				opts.outFiles.push_back (optarg);
 				break;
 			case 'r' :
 				jDBG ("r: name " << glyphOptions[optIdx].name
 						<<" optarg "<< optarg);
-				strcpy (refFile, optarg);
+				opts.refFile = optarg;
+				break;
+			case 'm' :
+				jDBG ("m: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				opts.manifest = optarg;
+				break;
+			case 'j' :
+				jDBG ("j: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				jobs = atoi (optarg);
+				if (jobs < 1)
+				{
+					jERR ("Invalid number of jobs " << optarg);
+					exit (1);
+				}
+				opts.jobs = jobs;
+				break;
+			case 'c' :
+				jDBG ("c: name " << glyphOptions[optIdx].name);
+				opts.compileRef = true;
+				break;
+			case 's' :
+				jDBG ("s: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				opts.statsFormat = optarg;
+				if ((opts.statsFormat != "text") && (opts.statsFormat != "json"))
+				{
+					jERR ("Statistics format has to be text or json");
+					exit (1);
+				}
+				break;
+			case 'S' :
+				jDBG ("S: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				opts.statsFile = optarg;
+				break;
+			case 'M' :
+				jDBG ("M: name " << glyphOptions[optIdx].name);
+				opts.memReport = true;
+				break;
+			case 'I' :
+				jDBG ("I: name " << glyphOptions[optIdx].name);
+				opts.renameOpts.useCache = true;
+				break;
+			case 'X' :
+				jDBG ("X: name " << glyphOptions[optIdx].name);
+				opts.renameOpts.strict = true;
+				break;
+			case 'p' :
+				jDBG ("p: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				threads = atoi (optarg);
+				if (threads < 1)
+				{
+					jERR ("Invalid number of threads " << optarg);
+					exit (1);
+				}
+				opts.fontThreads = threads;
+				break;
+			case 'E' :
+				jDBG ("E: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				opts.renameOpts.exportMap = optarg;
+				break;
+			case 'A' :
+				jDBG ("A: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				opts.applyMap = optarg;
+				break;
+			case 'D' :
+				jDBG ("D: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				opts.serveSocket = optarg;
+				break;
+			case 'V' :
+				jDBG ("V: name " << glyphOptions[optIdx].name);
+				verify = true;
+				break;
+			case 'C' :
+				jDBG ("C: name " << glyphOptions[optIdx].name);
+				corpus = true;
+				break;
+			case 'N' :
+				jDBG ("N: name " << glyphOptions[optIdx].name);
+				opts.listNames = true;
 				break;
 			case 'l' :
 				jDBG ("l: name " << glyphOptions[optIdx].name
 						<<" optarg "<< optarg);
-				lvl = optarg;
-				jDBG ("Log level " << lvl);
+				opts.logLvl = optarg;
+				jDBG ("Log level " << opts.logLvl);
+				break;
+			case 'L' :
+				jDBG ("L: name " << glyphOptions[optIdx].name
+						<<" optarg "<< optarg);
+				opts.logFile = optarg;
 				break;
 			case '?' :
 				jDBG ("Try " << argv[0] << " --help for more information");
@@ -1261,112 +861,116 @@ int processArgs (int argc, char **argv, char *inFile, char *outFile, char *refFi
 
 	}
 
-	if (strlen (inFile) == 0)
+	if (opts.listNames && !corpus)
 	{
-		jERR ("Input SFD file not specified, try " << argv[0] << " -h");
+		jERR ("--list-names needs --corpus-stats");
 		exit (1);
 	}
 
-	if (strlen (outFile) == 0)
+	//! The files to verify or compare follow the options. Only the
+	//! parsing, logging and report options apply.
+	if (verify || corpus)
 	{
-		jERR ("Output SFD file not specified, try " << argv[0] << " -h");
-		exit (1);
+		if (verify && corpus)
+		{
+			jERR ("--verify and --corpus-stats cannot be used together");
+			exit (1);
+		}
+		if (!opts.inFiles.empty () || !opts.outFiles.empty ()
+			|| !opts.manifest.empty () || opts.compileRef
+			|| opts.renameOpts.useCache || !opts.renameOpts.exportMap.empty ()
+			|| !opts.applyMap.empty () || !opts.serveSocket.empty ())
+		{
+			jERR ("-i, -o, -m, -c, -I, --export-map, --apply-map and --serve"
+				" cannot be used with " << (verify ? "--verify" : "--corpus-stats"));
+			exit (1);
+		}
 	}
 
-	if (strlen (refFile) == 0)
+	//! The reference font comes first, then the fonts compared with it.
+	if (corpus)
 	{
-		jERR ("Reference file not specified, try " << argv[0] << " -h");
-		exit (1);
+		for (int i = optind; i < argc; i++)
+		{
+			opts.corpusFiles.push_back (argv[i]);
+		}
+		if (opts.corpusFiles.size () < 2)
+		{
+			jERR ("--corpus-stats needs the reference SFD file and at least"
+				" one SFD file to compare, try " << argv[0] << " -h");
+			exit (1);
+		}
+		return SUCCESS;
 	}
-	return SUCCESS;
-}
-
-//! \fn int checkDups (vector<FontChar>& vFontChar, unsigned int idx, string newName)
-//! \brief Check if the new name is already taken
-//! \param [in] vFontChar FontChar vector
-//! \param [in] idx Index of the glyph in FontChar vector.
-//! \param [in] newName The new name for the glyph.
-//! \returns FAIL if the name is already in use.
-int checkDups (vector<FontChar>& vFontChar, unsigned int idx, string newName)
-{
 
-	string fcCurName;
-	string fcNewName;
-	jTRACE ("Checking for existing name [" << newName << "]");
-	
-	//! Search through the FontChar vector.
-	for (unsigned int i = 0; i < vFontChar.size (); i++)
+	//! The files to verify come in pairs.
+	if (verify)
 	{
-		if (i == idx)
+		for (int i = optind; i < argc; i++)
 		{
-			// This is the search key, skip it.
-			jDBG ("Skipping " << i);
-			continue;
+			opts.verifyFiles.push_back (argv[i]);
 		}
-
-		//! Check both current and new name of the glyphs.
-		fcCurName = vFontChar[i].getCurName();
-		fcNewName = vFontChar[i].getNewName();
-		if (fcCurName == newName )
+		if (opts.verifyFiles.empty () || (opts.verifyFiles.size () % 2 != 0))
 		{
-			//! If found being used, return fail.
-			jDBG ("Name already exists [" << fcCurName << "] at " << i);
-			return FAIL;
+			jERR ("--verify needs pairs of input and output SFD files, try "
+				<< argv[0] << " -h");
+			exit (1);
 		}
+		return SUCCESS;
+	}
 
-		if (fcNewName == newName )
+	//! The rename map takes the place of the reference file, the names
+	//! are not resolved again.
+	if (!opts.applyMap.empty ())
+	{
+		if (opts.compileRef || opts.renameOpts.useCache
+			|| !opts.renameOpts.exportMap.empty ())
 		{
-			jDBG ("Name already exists [" << fcNewName << "] at " << i);
-			return FAIL;
+			jERR ("-c, -I and --export-map cannot be used with --apply-map");
+			exit (1);
 		}
 	}
-	
-	//! The new name is not being used, return SUCCESS.
-	jTRACE ("checkDups returning SUCCESS");
-	return SUCCESS;
-}
-
-//! \fn int processHalfForms (string curName, string newName, string& hName)
-//! \brief Alternate naming method for some special glyphs
-//! \param [in] curName Current glyph name.
-//!	\param [in] newName New name built for the glyph.
-//! \param [out] hName The final new name.
-//! \returns SUCCESS if alternate name is found.
-//! \returns FAIL if alternate name is not found.
-//!
-//! Few glyphs need special naming, they are listed here:
-//! Old Names | New Name
-//! ----------|---------
-//! y1        | y2
-//! y1xx      | y2
-//! r3        | r4
-//! r3xx      | r4
-//! l3        | l4
-//! l3xx      | l4
-//! v1        | v2
-//! v1xx      | v2
+	else if (opts.refFile.empty ())
+	{
+		jERR ("Reference file not specified, try " << argv[0] << " -h");
+		exit (1);
+	}
 
-int processHalfForms (string curName, string newName, string& hName)
-{
-	map<string, string> specials;
+	//! Only the reference file is needed to compile it.
+	if (opts.compileRef)
+	{
+		return SUCCESS;
+	}
 
-	jTRACE ("processHalfForms [" << curName << "] [" << newName <<"]");
+	//! The fonts come from the clients of the server.
+	if (!opts.serveSocket.empty ())
+	{
+		if (!opts.inFiles.empty () || !opts.outFiles.empty ()
+			|| !opts.manifest.empty () || !opts.renameOpts.exportMap.empty ())
+		{
+			jERR ("-i, -o, -m and --export-map cannot be used with --serve");
+			exit (1);
+		}
+		return SUCCESS;
+	}
 
-	specials["y1"] = "y2";
-	specials["y1xx"] = "y2";
-	specials["r3"] = "r4";
-	specials["r3xx"] = "r4";
-	specials["l3"] = "l4";
-	specials["l3xx"] = "l4";
-	specials["v1"] = "v2";
-	specials["v1xx"] = "v2";
+	if (opts.inFiles.empty () && opts.manifest.empty ())
+	{
+		jERR ("Input SFD file not specified, try " << argv[0] << " -h");
+		exit (1);
+	}
 
-	if (specials[newName] == curName)
+	if (opts.outFiles.empty () && opts.manifest.empty ())
 	{
-		hName = curName;
-		jTRACE ("Setting special to [" << hName << "]");
-		return SUCCESS;
+		jERR ("Output SFD file not specified, try " << argv[0] << " -h");
+		exit (1);
 	}
 
-	return FAIL;
+	if (opts.inFiles.size () != opts.outFiles.size ())
+	{
+		jERR ("Number of input and output SFD files differ, try "
+			<< argv[0] << " -h");
+		exit (1);
+	}
+	return SUCCESS;
 }
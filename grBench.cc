@@ -0,0 +1,358 @@
+using namespace std;
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <getopt.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "sfdRename.hpp"
+#include "sfdGen.hpp"
+#include "jlog.hpp"
+
+//! \file grBench.cc
+//! \brief Benchmark of the glyphRen phases on synthetic fonts.
+//!
+//! Usage : grBench [-s sizes] [-n ligatures] [-d depth] [-c collisions]
+//!		[-r repeats] [-p threads] [-w workDir] [-f text | csv]
+//!		grBench -g -s glyphs [-n ..] -o outputSFD -R outputReference
+//!
+//! For each size (number of glyphs) a font is generated with sfdGen, and
+//! loadReferenceData, analyzeSFDFile, renameGlyphs and writeNewSFD are
+//! timed separately. The best of the repeats is reported along with the
+//! throughput and the scaling against the previous size: the growth of
+//! the time divided by the growth of the size, 1.00 being linear.
+//!
+//! With -g the generated SFD and reference files are written out and
+//! nothing is timed.
+
+//! Time taken by each phase, in milliseconds.
+struct PhaseTimes
+{
+	double refLoad = 0; //!< loadReferenceData
+	double analyze = 0; //!< SFD load and analyzeSFDFile
+	double rename = 0; //!< renameGlyphs
+	double write = 0; //!< writeNewSFD
+
+	double total (void) const {return refLoad + analyze + rename + write;}
+};
+
+//! Benchmark options.
+struct BenchOptions
+{
+	vector<unsigned int> sizes; //!< Glyph counts to run.
+	GenParams gen; //!< Shape of the generated fonts.
+	unsigned int repeats = 3; //!< Runs per size, the best is reported.
+	unsigned int fontThreads = 1; //!< Threads parsing the SFD file.
+	string workDir = "benchData"; //!< Directory for the generated files.
+	string format = "text"; //!< Report format, text or csv.
+	bool generateOnly = false; //!< Write the files given by -o/-R.
+	string outSfd; //!< SFD file for -g.
+	string outRef; //!< Reference file for -g.
+};
+
+int runPhases (const string& sfdFile, const string& refFile, const string& outFile, unsigned int fontThreads, PhaseTimes& t);
+int writeFile (const string& fileName, const string& data);
+void help (char *progName);
+int processArgs (int argc, char **argv, BenchOptions& opts);
+
+//! Milliseconds elapsed since start.
+static double msSince (chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli> (chrono::steady_clock::now () - start).count ();
+}
+
+//! \fn int main (int argc, char **argv)
+//! \brief Starting point of grBench.
+int main (int argc, char **argv)
+{
+	BenchOptions opts;
+	processArgs (argc, argv, opts);
+
+	//! Only errors and warnings, the phases log at LOG level.
+	JMINLVL = FATAL | ERROR | WARN;
+	SETMSGLVL (WARN);
+
+	if (opts.generateOnly)
+	{
+		string sfd;
+		string ref;
+		opts.gen.glyphCount = opts.sizes[0];
+		if ((generateFont (opts.gen, sfd, ref) != SUCCESS)
+			|| (writeFile (opts.outSfd, sfd) != SUCCESS)
+			|| (writeFile (opts.outRef, ref) != SUCCESS))
+		{
+			return (2);
+		}
+		return (0);
+	}
+
+	mkdir (opts.workDir.c_str (), 0755);
+
+	if (opts.format == "csv")
+	{
+		cout << "glyphs,refload_ms,analyze_ms,rename_ms,write_ms,total_ms,"
+			"glyphs_per_s,mb_per_s,scaling" << endl;
+	}
+	else
+	{
+		printf ("ligatures/glyph %u, chain depth %u, collisions %.2f, best of %u,"
+			" font threads %u\n", opts.gen.ligsPerGlyph, opts.gen.chainDepth,
+			opts.gen.collideFrac, opts.repeats, opts.fontThreads);
+		printf ("%9s %10s %10s %10s %10s %10s %12s %8s %8s\n", "glyphs",
+			"ref ms", "analyze ms", "rename ms", "write ms", "total ms",
+			"glyphs/s", "MB/s", "scaling");
+	}
+
+	double prevTotal = 0;
+	unsigned int prevSize = 0;
+	for (unsigned int s = 0; s < opts.sizes.size (); s++)
+	{
+		string sfd;
+		string ref;
+		opts.gen.glyphCount = opts.sizes[s];
+		if (generateFont (opts.gen, sfd, ref) != SUCCESS)
+		{
+			jERR ("Unable to generate a font of " << opts.sizes[s] << " glyphs");
+			return (2);
+		}
+
+		string base = opts.workDir + "/bench" + to_string (opts.sizes[s]);
+		if ((writeFile (base + ".sfd", sfd) != SUCCESS)
+			|| (writeFile (base + ".nam", ref) != SUCCESS))
+		{
+			return (2);
+		}
+
+		PhaseTimes best;
+		for (unsigned int r = 0; r < opts.repeats; r++)
+		{
+			PhaseTimes t;
+			if (runPhases (base + ".sfd", base + ".nam", base + ".out.sfd",
+				opts.fontThreads, t) != SUCCESS)
+			{
+				return (2);
+			}
+			if ((r == 0) || (t.total () < best.total ()))
+			{
+				best = t;
+			}
+		}
+
+		double glyphRate = opts.sizes[s] / (best.total () / 1000);
+		double mbRate = sfd.size () / (best.total () / 1000) / (1024 * 1024);
+		double scaling = 0;
+		if (prevSize != 0)
+		{
+			scaling = (best.total () / prevTotal)
+				/ ((double) opts.sizes[s] / prevSize);
+		}
+
+		if (opts.format == "csv")
+		{
+			cout << opts.sizes[s] << "," << best.refLoad << "," << best.analyze
+				<< "," << best.rename << "," << best.write << "," << best.total ()
+				<< "," << glyphRate << "," << mbRate << "," << scaling << endl;
+		}
+		else
+		{
+			printf ("%9u %10.2f %10.2f %10.2f %10.2f %10.2f %12.0f %8.1f ",
+				opts.sizes[s], best.refLoad, best.analyze, best.rename,
+				best.write, best.total (), glyphRate, mbRate);
+			if (prevSize != 0)
+			{
+				printf ("%8.2f\n", scaling);
+			}
+			else
+			{
+				printf ("%8s\n", "-");
+			}
+		}
+		prevTotal = best.total ();
+		prevSize = opts.sizes[s];
+	}
+	return (0);
+}
+
+//! \fn int runPhases (const string& sfdFile, const string& refFile, const string& outFile, unsigned int fontThreads, PhaseTimes& t)
+//! \brief Run the phases of renameFont () and time each of them.
+//! \param [in] sfdFile Input SFD file.
+//! \param [in] refFile Reference file.
+//! \param [in] outFile Output SFD file.
+//! \param [in] fontThreads Threads parsing the SFD file.
+//! \param [out] t Time taken by each phase.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if any of the phases failed.
+int runPhases (const string& sfdFile, const string& refFile,
+	const string& outFile, unsigned int fontThreads, PhaseTimes& t)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now ();
+	RenameStats stats;
+	RefTable ref;
+	if (loadReferenceData (refFile.c_str (), ref) != SUCCESS)
+	{
+		jERR ("loadReferenceData failed for " << refFile);
+		return FAIL;
+	}
+	t.refLoad = msSince (start);
+
+	start = chrono::steady_clock::now ();
+	SfdBuffer sfdBuf;
+	NameTable names;
+	GlyphStore glyphs;
+	vector<SfdSpan> vSpan;
+	if ((sfdBuf.loadFile (sfdFile.c_str ()) != SUCCESS)
+		|| (analyzeSFDFile (sfdBuf, names, glyphs, vSpan, stats,
+			fontThreads) != SUCCESS))
+	{
+		jERR ("analyzeSFDFile failed for " << sfdFile);
+		return FAIL;
+	}
+	t.analyze = msSince (start);
+
+	start = chrono::steady_clock::now ();
+	vector<int> nameMap (names.getCount (), NO_NAME);
+	int renCount = 0;
+	if (renameGlyphs (ref, names, glyphs, nameMap, renCount, stats) != SUCCESS)
+	{
+		jERR ("renameGlyphs failed for " << sfdFile);
+		return FAIL;
+	}
+	t.rename = msSince (start);
+
+	start = chrono::steady_clock::now ();
+	if (writeNewSFD (sfdBuf, vSpan, outFile.c_str (), -1, names, nameMap,
+		stats) != SUCCESS)
+	{
+		jERR ("writeNewSFD failed for " << outFile);
+		return FAIL;
+	}
+	t.write = msSince (start);
+	return SUCCESS;
+}
+
+//! \fn int writeFile (const string& fileName, const string& data)
+//! \brief Write the data to the file.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be written.
+int writeFile (const string& fileName, const string& data)
+{
+	ofstream out (fileName, ios::binary);
+	out.write (data.data (), data.size ());
+	out.close ();
+	if (out.fail ())
+	{
+		jERR ("Unable to write " << fileName);
+		return FAIL;
+	}
+	return SUCCESS;
+}
+
+//! \fn void help (char *progName)
+//! \brief Display the help text.
+void help (char *progName)
+{
+	cout << "Usage : " << progName << " [options]" << endl;
+	cout << "\t -s Comma separated glyph counts"
+		" (1000,10000,100000,1000000)" << endl;
+	cout << "\t -n Ligatures per composite glyph (1)" << endl;
+	cout << "\t -d Ligature chain depth (2)" << endl;
+	cout << "\t -c Fraction of composite names that collide (0.1)" << endl;
+	cout << "\t -r Runs per size, the best is reported (3)" << endl;
+	cout << "\t -p Threads parsing the SFD file (1)" << endl;
+	cout << "\t -w Directory for the generated files (benchData)" << endl;
+	cout << "\t -f Report format, text or csv (text)" << endl;
+	cout << "\t -g Only generate a font of the first size, needs -o and -R" << endl;
+	cout << "\t -o Output SFD file for -g" << endl;
+	cout << "\t -R Output reference file for -g" << endl;
+	cout << "\t -h Display this help message" << endl;
+}
+
+//! \fn int processArgs (int argc, char **argv, BenchOptions& opts)
+//! \brief Process and validate the input arguments.
+//! \param [in] argc argc from main().
+//! \param [in] argv argv from main().
+//! \param [out] opts The options.
+int processArgs (int argc, char **argv, BenchOptions& opts)
+{
+	int c;
+	string sizes = "1000,10000,100000,1000000";
+
+	while ((c = getopt (argc, argv, "s:n:d:c:r:p:w:f:go:R:h")) != -1)
+	{
+		switch (c)
+		{
+			case 's' :
+				sizes = optarg;
+				break;
+			case 'n' :
+				opts.gen.ligsPerGlyph = atoi (optarg);
+				break;
+			case 'd' :
+				opts.gen.chainDepth = atoi (optarg);
+				break;
+			case 'c' :
+				opts.gen.collideFrac = atof (optarg);
+				break;
+			case 'r' :
+				opts.repeats = atoi (optarg);
+				break;
+			case 'p' :
+				opts.fontThreads = atoi (optarg);
+				break;
+			case 'w' :
+				opts.workDir = optarg;
+				break;
+			case 'f' :
+				opts.format = optarg;
+				break;
+			case 'g' :
+				opts.generateOnly = true;
+				break;
+			case 'o' :
+				opts.outSfd = optarg;
+				break;
+			case 'R' :
+				opts.outRef = optarg;
+				break;
+			case 'h' :
+				help (argv[0]);
+				exit (1);
+			default :
+				help (argv[0]);
+				exit (2);
+		}
+	}
+
+	istringstream sizeList (sizes);
+	string size;
+	while (getline (sizeList, size, ','))
+	{
+		int n = atoi (size.c_str ());
+		if (n < 3)
+		{
+			jERR ("Invalid glyph count " << size);
+			exit (1);
+		}
+		opts.sizes.push_back (n);
+	}
+
+	if (opts.sizes.empty () || (opts.repeats == 0) || (opts.fontThreads == 0)
+		|| (opts.gen.ligsPerGlyph == 0)
+		|| (opts.gen.chainDepth == 0)
+		|| ((opts.format != "text") && (opts.format != "csv")))
+	{
+		help (argv[0]);
+		exit (1);
+	}
+	if (opts.generateOnly && (opts.outSfd.empty () || opts.outRef.empty ()))
+	{
+		jERR ("-g needs -o and -R");
+		exit (1);
+	}
+	return SUCCESS;
+}
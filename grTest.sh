@@ -63,7 +63,11 @@ do
 	# Rename the glyphs.
 	newSFD="${fontName}.${suffix}.sfd"
 	log $LINENO "Renaming glyphs in $fontFile"
-	glyphRen -l TRACE -r $refFile -i $fontFile -o ${newSFD} > ${fontName}.log
+	# --strict fails on duplicate StartChar names in the input or output.
+	if ! glyphRen --strict -l TRACE -r $refFile -i $fontFile -o ${newSFD} > ${fontName}.log
+	then
+		err $LINENO "$fontName.sfd : Renaming failed or multiple StartChars, test failed. =============="
+	fi
 
 	# Generate the fonts.
 	# generate.pe "$fontFile" > /dev/null 2>&1
@@ -109,52 +113,19 @@ do
 		err $LINENO "$fontName : Rendered different, test failed. =============="
 	fi
 
-	grep StartChar ${fontName}.sfd | sort |uniq -c | sort -n > ${fontName}.count
-	uCount=`grep -c -v "^ *1" ${fontName}.count`
-	dbg $LINENO "uCount = ${uCount}"
-	if [[ "$uCount" -ne "0" ]]
-	then
-		err $LINENO "$fontName.sfd : Multiple StartChars, test failed. =============="
-	fi
-
-	grep StartChar ${fontName}.${suffix}.sfd | sort |uniq -c | sort -n > ${fontName}.${suffix}.count
-	uCount=`grep -c -v "^ *1" ${fontName}.${suffix}.count`
-	dbg $LINENO "uCount = ${uCount}"
-	if [[ "$uCount" -ne "0" ]]
-	then
-		err $LINENO "$fontName.${suffix}.sfd : Multiple StartChars, test failed. =============="
-	fi
-
 	echo ""
 
 	
 done < fonts.lst
 
 log $LINENO "Stats against Rachana.${suffix}.sfd"
-	grep "StartChar" Rachana.${suffix}.sfd |
-			awk -F": " '{print $2}' | sort > Rachana.${suffix}.srt
-printf "%s\n" "-----------------------------------------------------------------------------------"
-printf "%-25s |%20s |%15s |%15s |\n" "Fonts v / Glyphs >" "Unique in Rachana" "Unique in Font2" "Common"
-printf "%s\n" "-----------------------------------------------------------------------------------"
+# Each SFD file is read once, the fonts and their renamed files are
+# compared with the renamed Rachana font.
+corpus=""
 while read fontFile
 do
-	refSrt=Rachana.${suffix}.srt
 	fontName=`basename $fontFile .sfd`
-	grep "StartChar" ${fontName}.sfd |
-			awk -F": " '{print $2}' | sort > ${fontName}.srt 
-	uniq1=`comm -23 ${refSrt} ${fontName}.srt | wc -l`
-	uniq2=`comm -13 ${refSrt} ${fontName}.srt | wc -l`
-	common=`comm -12 ${refSrt} ${fontName}.srt | wc -l`
-	printf "%-25s |%20s |%15s |%15s |\n" ${fontName}	${uniq1} ${uniq2} ${common}
-
-
-	grep "StartChar" ${fontName}.${suffix}.sfd |
-			awk -F": " '{print $2}' | sort > ${fontName}.${suffix}.srt 
-	uniq1=`comm -23 ${refSrt} ${fontName}.${suffix}.srt | wc -l`
-	uniq2=`comm -13 ${refSrt} ${fontName}.${suffix}.srt | wc -l`
-	common=`comm -12 ${refSrt} ${fontName}.${suffix}.srt | wc -l`
-	printf "%-25s |%20s |%15s |%15s |\n" ${fontName}.${suffix} ${uniq1} ${uniq2} ${common}
-	printf "%s\n" "-----------------------------------------------------------------------------------"
-
+	corpus="$corpus ${fontName}.sfd ${fontName}.${suffix}.sfd"
 done < fonts.lst
+glyphRen --corpus-stats Rachana.${suffix}.sfd $corpus
 rm fonts.lst
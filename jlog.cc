@@ -1,6 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "jlog.hpp"
+using namespace std;
+
+//! \file jlog.cc
+//! \brief Ring buffer and writer thread behind the log macros.
 
 //! Minimum Log level the program that need to maintain.
 int JMINLVL = FATAL | ERROR | WARN | LOG | INFO;
@@ -9,3 +20,188 @@ int JLOGLVL = LOG; //!< The log level.
 int JLFWIDT = 6; //!< Width for the file name field in log messages.
 int JLLWIDT = 4; //!< Width for the line number filed in log messages.
 
+//! Messages waiting to be written and the state of the writer thread.
+//! Slots are filled at tail and written from head, both count messages
+//! from the start so that tail - head is the number of queued messages.
+struct JlogRing
+{
+	vector<string> slots = vector<string> (JLOG_RING_SIZE);
+	unsigned long head = 0; //!< Next message to write.
+	unsigned long tail = 0; //!< Next free slot.
+	unsigned long written = 0; //!< Messages handed to the sink.
+	bool started = false; //!< Writer thread is running.
+	bool stopping = false; //!< Writer thread has to exit once drained.
+	bool finished = false; //!< Shut down at exit, write directly.
+	FILE *sink = NULL; //!< NULL writes to stdout.
+	FILE *ownSink = NULL; //!< Sink opened by jlogOpen.
+	mutex lock;
+	condition_variable notEmpty;
+	condition_variable notFull;
+	condition_variable drained;
+	thread writer;
+};
+
+static JlogRing Ring;
+
+//! \fn static void jlogWriter (void)
+//! \brief Body of the writer thread.
+//! Takes all the queued messages at a time and writes them with a single
+//! flush for the batch.
+static void jlogWriter (void)
+{
+	vector<string> batch;
+	unique_lock<mutex> lk (Ring.lock);
+	while (1)
+	{
+		Ring.notEmpty.wait (lk, [] {return Ring.head != Ring.tail || Ring.stopping;});
+		if (Ring.head == Ring.tail)
+		{
+			break;
+		}
+
+		while (Ring.head != Ring.tail)
+		{
+			batch.emplace_back ();
+			batch.back ().swap (Ring.slots[Ring.head % JLOG_RING_SIZE]);
+			Ring.head++;
+		}
+		FILE *out = (Ring.sink != NULL) ? Ring.sink : stdout;
+		Ring.notFull.notify_all ();
+
+		lk.unlock ();
+		for (auto& msg : batch)
+		{
+			fwrite (msg.data (), 1, msg.size (), out);
+		}
+		fflush (out);
+		lk.lock ();
+
+		Ring.written += batch.size ();
+		batch.clear ();
+		Ring.drained.notify_all ();
+	}
+}
+
+//! \fn static void jlogShutdown (void)
+//! \brief Write the queued messages and stop the writer thread.
+//! Registered with atexit when the writer is started. The sink is left
+//! open, the messages logged by later exit handlers are written to it
+//! directly.
+static void jlogShutdown (void)
+{
+	{
+		lock_guard<mutex> lk (Ring.lock);
+		if (!Ring.started)
+		{
+			return;
+		}
+		Ring.stopping = true;
+	}
+	Ring.notEmpty.notify_one ();
+	Ring.writer.join ();
+
+	lock_guard<mutex> lk (Ring.lock);
+	Ring.started = false;
+	Ring.finished = true;
+}
+
+//! Formatting stream of the thread, reused across messages.
+static thread_local std::ostringstream JlogOs;
+
+//! \fn std::ostringstream& jlogStream (void)
+//! \brief Get the formatting stream of the calling thread.
+//! \returns The emptied stream.
+std::ostringstream& jlogStream (void)
+{
+	JlogOs.str ("");
+	JlogOs.clear ();
+	return JlogOs;
+}
+
+//! \fn void jlogCommit (void)
+//! \brief Queue the message formatted in the calling thread's stream.
+//! Starts the writer thread with the first message. Waits for a free slot
+//! if the ring is full, messages are never dropped.
+void jlogCommit (void)
+{
+	string msg = JlogOs.str ();
+
+	unique_lock<mutex> lk (Ring.lock);
+	if (Ring.finished)
+	{
+		//! Messages from the exit handlers run after the writer stopped.
+		FILE *out = (Ring.sink != NULL) ? Ring.sink : stdout;
+		fwrite (msg.data (), 1, msg.size (), out);
+		fflush (out);
+		return;
+	}
+	if (!Ring.started)
+	{
+		Ring.writer = thread (jlogWriter);
+		Ring.started = true;
+		atexit (jlogShutdown);
+	}
+	Ring.notFull.wait (lk, [] {return Ring.tail - Ring.head < JLOG_RING_SIZE;});
+	Ring.slots[Ring.tail % JLOG_RING_SIZE].swap (msg);
+	Ring.tail++;
+	lk.unlock ();
+	Ring.notEmpty.notify_one ();
+}
+
+//! \fn void jlogFlush (void)
+//! \brief Wait until the messages queued so far are written to the sink.
+void jlogFlush (void)
+{
+	unique_lock<mutex> lk (Ring.lock);
+	unsigned long target = Ring.tail;
+	if (!Ring.started)
+	{
+		return;
+	}
+	Ring.drained.wait (lk, [target] {return Ring.written >= target;});
+}
+
+//! \fn int jlogSetSink (FILE *sink)
+//! \brief Write the log messages to sink.
+//! Messages queued so far are written to the current sink first.
+//! \param [in] sink The stream, NULL selects stdout. The caller keeps the
+//! ownership and has to keep it open till the program exits.
+//! \returns 0
+int jlogSetSink (FILE *sink)
+{
+	jlogFlush ();
+
+	lock_guard<mutex> lk (Ring.lock);
+	if (Ring.ownSink != NULL)
+	{
+		fclose (Ring.ownSink);
+		Ring.ownSink = NULL;
+	}
+	Ring.sink = sink;
+	return 0;
+}
+
+//! \fn int jlogOpen (const char *fileName)
+//! \brief Write the log messages to the file.
+//! \param [in] fileName Name of the log file, "-" selects stdout.
+//! \returns 0 on success.
+//! \returns 1 if the file cannot be opened, the sink is not changed.
+int jlogOpen (const char *fileName)
+{
+	if (strcmp (fileName, "-") == 0)
+	{
+		return jlogSetSink (NULL);
+	}
+
+	FILE *fp = fopen (fileName, "w");
+	if (fp == NULL)
+	{
+		jERR ("Unable to open log file " << fileName << " : " << strerror (errno));
+		return 1;
+	}
+	jlogSetSink (fp);
+
+	lock_guard<mutex> lk (Ring.lock);
+	Ring.ownSink = fp;
+	return 0;
+}
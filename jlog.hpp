@@ -3,6 +3,9 @@
 
 #include <istream>
 #include <iomanip>
+#include <sstream>
+#include <string>
+#include <stdio.h>
 
 //! \file jlog.hpp
 //! \brief Simple Error/Log/Trace/Debug macros.
@@ -21,6 +24,13 @@
 //! Debug | DEBUG   | 32    | +-
 //! Trace | TRACE   | 64    | ++
 //!
+//! Messages are formatted by the calling thread and queued in a ring
+//! buffer. A background thread writes them to the sink (stdout unless
+//! changed by jlogSetSink () or jlogOpen ()) without flushing every line.
+//! The queue is drained at exit, or on demand with jlogFlush ().
+//!
+//! JLOG_COMPILE_LVL sets the most verbose level compiled into the
+//! program, eg. -DJLOG_COMPILE_LVL=16 removes jDBG and jTRACE messages.
 
 //! Available log levels.
 typedef enum {FATAL = 1, ERROR = 2, WARN = 4, LOG = 8, INFO = 16, DBG = 32, TRACE = 64} LVLS;
@@ -29,6 +39,41 @@ extern int JLLWIDT;
 extern int JLOGLVL;
 extern int JMINLVL;
 
+//! Most verbose level compiled in, messages above it are removed.
+#ifndef JLOG_COMPILE_LVL
+#define JLOG_COMPILE_LVL 64
+#endif
+
+//! Number of messages the ring buffer can hold.
+#define JLOG_RING_SIZE 4096
+
+//! Get the formatting stream of the calling thread, emptied.
+std::ostringstream& jlogStream (void);
+
+//! Queue the message in the calling thread's stream.
+void jlogCommit (void);
+
+//! Wait until all queued messages are written to the sink.
+void jlogFlush (void);
+
+//! Write the messages to sink, the caller keeps ownership of the stream.
+int jlogSetSink (FILE *sink);
+
+//! Write the messages to the file, "-" selects stdout.
+int jlogOpen (const char *fileName);
+
+//! Format and queue a message.
+#define JLOGMSG(tag, ind, x) \
+	do \
+	{ \
+		std::ostringstream& jlogOs = jlogStream (); \
+		jlogOs << tag << std::setw (JLFWIDT) <<  __FILE__ << ":" \
+		<< std::setw (JLLWIDT)  <<  __LINE__ << "] " \
+		<< ind << x << "]" << '\n'; \
+		jlogCommit (); \
+	} \
+	while (0)
+
 //! Width for file name in debug statements.
 #define FILE_W 13
 //! Width for line number in debug statements.
@@ -64,34 +109,21 @@ extern int JMINLVL;
 
 
 //! Displays Error message
-#define jERR(x) \
-	do \
-	{ \
-		std::cout << "[ERROR :" << setw (JLFWIDT) <<  __FILE__ << ":" \
-		<< std::setw (JLLWIDT)  <<  __LINE__ << "] " \
-		<< "==  [" << x << "]" << std::endl; \
-	} \
-	while (0)
+#define jERR(x) JLOGMSG ("[ERROR :", "==  [", x)
 
 //! Displays warning message
-#define jWARN(x) \
-	do \
-	{ \
-		std::cout << "[WARN :" << setw (JLFWIDT) <<  __FILE__ << ":" \
-		<< std::setw (JLLWIDT)  <<  __LINE__ << "] " \
-		<< "=-  [" << x << "]" << std::endl; \
-	} \
-	while (0)
+#define jWARN(x) JLOGMSG ("[WARN :", "=-  [", x)
 
 //! Displays Log message
 #define jLOG(x) \
 	do \
 	{ \
-		if (JLOGLVL >= LOG) \
+		if constexpr (JLOG_COMPILE_LVL >= LOG) \
 		{ \
-			std::cout << "[LOG   :" << setw (JLFWIDT) <<  __FILE__ << ":" \
-			<< std::setw (JLLWIDT)  <<  __LINE__ << "] " \
-			<< "-- [" << x << "]" << std::endl; \
+			if (JLOGLVL >= LOG) \
+			{ \
+				JLOGMSG ("[LOG   :", "-- [", x); \
+			} \
 		} \
 	} \
 	while (0)
@@ -100,11 +132,12 @@ extern int JMINLVL;
 #define jINFO(x) \
 	do \
 	{ \
-		if (JLOGLVL >= INFO) \
+		if constexpr (JLOG_COMPILE_LVL >= INFO) \
 		{ \
-			std::cout << "[INFO   :" << setw (JLFWIDT) <<  __FILE__ << ":" \
-			<< std::setw (JLLWIDT)  <<  __LINE__ << "] " \
-			<< "-+ [" << x << "]" << std::endl; \
+			if (JLOGLVL >= INFO) \
+			{ \
+				JLOGMSG ("[INFO   :", "-+ [", x); \
+			} \
 		} \
 	} \
 	while (0)
@@ -113,11 +146,12 @@ extern int JMINLVL;
 #define jDBG(x) \
 	do \
 	{ \
-		if (JLOGLVL >= DBG) \
+		if constexpr (JLOG_COMPILE_LVL >= DBG) \
 		{ \
-			std::cout << "[DEBUG :" << setw (JLFWIDT) <<  __FILE__ << ":" \
-			<< std::setw (JLLWIDT)  <<  __LINE__ << "] " \
-			<< "+- [" << x << "]" << std::endl; \
+			if (JLOGLVL >= DBG) \
+			{ \
+				JLOGMSG ("[DEBUG :", "+- [", x); \
+			} \
 		} \
 	} \
 	while (0)
@@ -126,11 +160,12 @@ extern int JMINLVL;
 #define jTRACE(x) \
 	do \
 	{ \
-		if (JLOGLVL >= TRACE) \
+		if constexpr (JLOG_COMPILE_LVL >= TRACE) \
 		{ \
-			std::cout << "[TRACE :" << setw (JLFWIDT) <<  __FILE__ << ":" \
-			<< std::setw (JLLWIDT)  <<  __LINE__ << "] " \
-			<< "++ [" << x << "]" << std::endl; \
+			if (JLOGLVL >= TRACE) \
+			{ \
+				JLOGMSG ("[TRACE :", "++ [", x); \
+			} \
 		} \
 	} \
 	while (0)
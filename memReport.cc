@@ -0,0 +1,216 @@
+#include <new>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include "memReport.hpp"
+//! \file memReport.cc
+//! \brief Replacement operator new and delete that count the allocations.
+//!
+//! The sizes are taken from malloc_usable_size (), so no header is added
+//! to the blocks and the numbers are the real heap use, which is a bit
+//! more than the sizes asked for. Counting is off until memReportEnable ()
+//! is called, the cost is then a few relaxed atomic operations per call.
+
+//! Counters of a phase.
+struct MemCounters
+{
+	atomic<unsigned long> allocs; //!< Number of allocations.
+	atomic<unsigned long> frees; //!< Number of frees.
+	atomic<unsigned long> allocBytes; //!< Bytes allocated.
+	atomic<unsigned long> freeBytes; //!< Bytes freed.
+	atomic<long> peakLive; //!< Highest live heap seen in the phase.
+};
+
+static atomic<bool> MemEnabled (false); //!< Set by memReportEnable ()
+static MemCounters MemPhases[MEM_PHASES]; //!< Counters per phase
+static atomic<long> MemLive (0); //!< Bytes allocated and not freed.
+static thread_local int MemCurPhase = MEM_OTHER; //!< Phase of the thread.
+
+//! Names of the phases in the report.
+static const char *MemPhaseNames[MEM_PHASES] = {"other", "reference", "parse", "rename", "write"};
+
+//! Set the phase of the thread.
+MemPhase::MemPhase (int phase)
+{
+	prevPhase = MemCurPhase;
+	MemCurPhase = phase;
+}
+
+//! Move the thread to another phase, the destructor still restores the
+//! phase from before the construction.
+void MemPhase::set (int phase)
+{
+	MemCurPhase = phase;
+}
+
+//! Restore the previous phase.
+MemPhase::~MemPhase ()
+{
+	MemCurPhase = prevPhase;
+}
+
+//! Start counting the allocations.
+void memReportEnable (void)
+{
+	MemEnabled.store (true, memory_order_relaxed);
+}
+
+//! Count an allocation.
+static void memCountAlloc (void *ptr)
+{
+	long size = malloc_usable_size (ptr);
+	MemCounters& c = MemPhases[MemCurPhase];
+	c.allocs.fetch_add (1, memory_order_relaxed);
+	c.allocBytes.fetch_add (size, memory_order_relaxed);
+
+	long live = MemLive.fetch_add (size, memory_order_relaxed) + size;
+	long peak = c.peakLive.load (memory_order_relaxed);
+	while ((live > peak)
+		&& !c.peakLive.compare_exchange_weak (peak, live, memory_order_relaxed))
+	{
+	}
+}
+
+//! Count a free.
+static void memCountFree (void *ptr)
+{
+	long size = malloc_usable_size (ptr);
+	MemCounters& c = MemPhases[MemCurPhase];
+	c.frees.fetch_add (1, memory_order_relaxed);
+	c.freeBytes.fetch_add (size, memory_order_relaxed);
+	MemLive.fetch_sub (size, memory_order_relaxed);
+}
+
+//! Allocate size bytes, calling the new handler as operator new does.
+static void *memAlloc (size_t size)
+{
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	void *ptr;
+	while ((ptr = malloc (size)) == NULL)
+	{
+		new_handler handler = get_new_handler ();
+		if (handler == NULL)
+		{
+			return NULL;
+		}
+		handler ();
+	}
+
+	if (MemEnabled.load (memory_order_relaxed))
+	{
+		memCountAlloc (ptr);
+	}
+	return ptr;
+}
+
+//! Free the block.
+static void memFree (void *ptr)
+{
+	if (ptr == NULL)
+	{
+		return;
+	}
+	if (MemEnabled.load (memory_order_relaxed))
+	{
+		memCountFree (ptr);
+	}
+	free (ptr);
+}
+
+void *operator new (size_t size)
+{
+	void *ptr = memAlloc (size);
+	if (ptr == NULL)
+	{
+		throw bad_alloc ();
+	}
+	return ptr;
+}
+
+void *operator new[] (size_t size)
+{
+	return operator new (size);
+}
+
+void *operator new (size_t size, const nothrow_t&) noexcept
+{
+	return memAlloc (size);
+}
+
+void *operator new[] (size_t size, const nothrow_t&) noexcept
+{
+	return memAlloc (size);
+}
+
+void operator delete (void *ptr) noexcept
+{
+	memFree (ptr);
+}
+
+void operator delete[] (void *ptr) noexcept
+{
+	memFree (ptr);
+}
+
+void operator delete (void *ptr, size_t) noexcept
+{
+	memFree (ptr);
+}
+
+void operator delete[] (void *ptr, size_t) noexcept
+{
+	memFree (ptr);
+}
+
+void operator delete (void *ptr, const nothrow_t&) noexcept
+{
+	memFree (ptr);
+}
+
+void operator delete[] (void *ptr, const nothrow_t&) noexcept
+{
+	memFree (ptr);
+}
+
+//! \fn void memReportPrint (ostream& out)
+//! \brief Write the allocation counts per phase as a table.
+//! Peak live is the highest heap use, of all the threads, seen by an
+//! allocation made in the phase.
+//! \param [in] out The stream.
+void memReportPrint (ostream& out)
+{
+	char row[160];
+	snprintf (row, sizeof (row), "%-10s %12s %12s %16s %16s %16s\n", "Phase",
+		"Allocs", "Frees", "Bytes alloc", "Bytes freed", "Peak live");
+	out << row;
+
+	unsigned long totAllocs = 0;
+	unsigned long totFrees = 0;
+	unsigned long totAllocBytes = 0;
+	unsigned long totFreeBytes = 0;
+	long peak = 0;
+	for (int i = 0; i < MEM_PHASES; i++)
+	{
+		MemCounters& c = MemPhases[i];
+		snprintf (row, sizeof (row), "%-10s %12lu %12lu %16lu %16lu %16ld\n",
+			MemPhaseNames[i], c.allocs.load (), c.frees.load (),
+			c.allocBytes.load (), c.freeBytes.load (), c.peakLive.load ());
+		out << row;
+		totAllocs += c.allocs.load ();
+		totFrees += c.frees.load ();
+		totAllocBytes += c.allocBytes.load ();
+		totFreeBytes += c.freeBytes.load ();
+		if (c.peakLive.load () > peak)
+		{
+			peak = c.peakLive.load ();
+		}
+	}
+	snprintf (row, sizeof (row), "%-10s %12lu %12lu %16lu %16lu %16ld\n",
+		"total", totAllocs, totFrees, totAllocBytes, totFreeBytes, peak);
+	out << row;
+}
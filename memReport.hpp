@@ -0,0 +1,37 @@
+#ifndef __MEMREPORT_H
+#define __MEMREPORT_H
+using namespace std;
+#include <ostream>
+//! \file memReport.hpp
+//! \brief Heap accounting per phase, for --mem-report.
+//!
+//! memReport.cc replaces the global operator new and delete. Once
+//! memReportEnable () is called, every allocation and free is counted
+//! against the phase of the calling thread, set with MemPhase.
+
+//! Phases the allocations are attributed to.
+typedef enum {MEM_OTHER = 0, MEM_REFLOAD, MEM_PARSE, MEM_RENAME, MEM_WRITE, MEM_PHASES} MEMPHASES;
+
+//! Sets the phase of the calling thread for its lifetime, the previous
+//! phase is restored by the destructor.
+class MemPhase
+{
+public:
+	MemPhase (int phase);
+	~MemPhase ();
+	MemPhase (const MemPhase&) = delete;
+	MemPhase& operator= (const MemPhase&) = delete;
+
+	//! Move the thread to another phase.
+	void set (int phase);
+private:
+	int prevPhase; //!< Phase to restore.
+};
+
+//! Start counting the allocations.
+void memReportEnable (void);
+
+//! Write the allocation counts per phase as a table.
+void memReportPrint (ostream& out);
+
+#endif
@@ -0,0 +1,204 @@
+#include <iostream>
+#include <fstream>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "nameCache.hpp"
+#include "sfdBuffer.hpp"
+#include "sfdTok.hpp"
+#include "jlog.hpp"
+//! \file nameCache.cc
+//! \brief NameCache implementation
+
+//! \fn int NameCache::load (const char *cacheFile, uint64_t refHash)
+//! \brief Load the glyphs of the previous run.
+//! \param [in] cacheFile Name of the cache file.
+//! \param [in] refHash Hash of the reference file of this run.
+//! \returns SUCCESS if the cache is loaded.
+//! \returns FAIL if the cache is missing, not valid or was written with
+//! another reference file.
+int NameCache::load (const char *cacheFile, uint64_t refHash)
+{
+	entries.clear ();
+	byName.clear ();
+
+	if (access (cacheFile, R_OK) != 0)
+	{
+		jDBG ("No name cache " << cacheFile);
+		return FAIL;
+	}
+
+	SfdBuffer cacheBuf;
+	if (cacheBuf.loadFile (cacheFile) != SUCCESS)
+	{
+		return FAIL;
+	}
+
+	SfdTokenizer tok;
+	string_view line;
+	string_view field;
+	size_t pos = 0;
+	unsigned long count = 0;
+	if ((cacheBuf.nextLine (pos, line) != SUCCESS)
+		|| (tok.split (line, '\t') != 3)
+		|| (tok.getTok (1, field) != SUCCESS) || (field != NAME_CACHE_MAGIC))
+	{
+		jWARN ("Name cache " << cacheFile << " is not valid, ignored");
+		return FAIL;
+	}
+	tok.getTok (2, field);
+	if (strtoull (string (field).c_str (), NULL, 16) != refHash)
+	{
+		jLOG ("Name cache " << cacheFile
+			<< " was written with another reference file, ignored");
+		return FAIL;
+	}
+	tok.getTok (3, field);
+	count = strtoul (string (field).c_str (), NULL, 10);
+
+	while (cacheBuf.nextLine (pos, line) == SUCCESS)
+	{
+		NameCacheEntry entry;
+		if ((tok.split (line, '\t') < 2) || (tok.getTok (1, field) != SUCCESS))
+		{
+			jWARN ("Name cache " << cacheFile << " is not valid, ignored");
+			entries.clear ();
+			byName.clear ();
+			return FAIL;
+		}
+		entry.fingerprint = strtoull (string (field).c_str (), NULL, 16);
+		tok.getTok (2, field);
+		entry.curName = field;
+		if (tok.getTok (3, field) == SUCCESS)
+		{
+			entry.newName = field;
+		}
+		if (tok.getTok (4, field) == SUCCESS)
+		{
+			entry.builtName = field;
+		}
+		byName[entry.curName].push_back (entries.size ());
+		entries.push_back (entry);
+	}
+
+	if (entries.size () != count)
+	{
+		jWARN ("Name cache " << cacheFile << " is truncated, ignored");
+		entries.clear ();
+		byName.clear ();
+		return FAIL;
+	}
+	jDBG ("Loaded " << count << " glyph(s) from " << cacheFile);
+	return SUCCESS;
+}
+
+//! \fn int NameCache::save (const char *cacheFile, uint64_t refHash, NameTable& names, GlyphStore& glyphs, vector<int>& nameMap)
+//! \brief Write the glyphs and the names given to them to the cache.
+//! The file is written under a temporary name and renamed, an interrupted
+//! run leaves the previous cache in place.
+//! \param [in] cacheFile Name of the cache file.
+//! \param [in] refHash Hash of the reference file.
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] glyphs The renamed glyphs.
+//! \param [in] nameMap The rename map, indexed by the old name ID.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be written.
+int NameCache::save (const char *cacheFile, uint64_t refHash,
+	NameTable& names, GlyphStore& glyphs, vector<int>& nameMap)
+{
+	string tmpFile = string (cacheFile) + ".tmp";
+	ofstream out (tmpFile, ios::binary);
+	if (! out.is_open ())
+	{
+		jERR ("Unable to open " << tmpFile);
+		return FAIL;
+	}
+
+	char hex[24];
+	snprintf (hex, sizeof (hex), "%016llx", (unsigned long long) refHash);
+	out << NAME_CACHE_MAGIC << '\t' << hex << '\t' << glyphs.getCount () << '\n';
+	for (unsigned int i = 0; i < glyphs.getCount (); i++)
+	{
+		const string& curName = names.getName (glyphs.getCurId (i));
+		const string& newName = names.getName (nameMap[glyphs.getCurId (i)]);
+		const string& builtName = names.getName (glyphs.getBuiltId (i));
+		if ((curName.find_first_of ("\t\n") != string::npos)
+			|| (newName.find_first_of ("\t\n") != string::npos)
+			|| (builtName.find_first_of ("\t\n") != string::npos))
+		{
+			jWARN ("Glyph name [" << curName
+				<< "] cannot be cached, name cache not written");
+			out.close ();
+			unlink (tmpFile.c_str ());
+			return FAIL;
+		}
+
+		snprintf (hex, sizeof (hex), "%016llx",
+			(unsigned long long) glyphs.getFingerprint (i));
+		out << hex << '\t' << curName << '\t' << newName << '\t' << builtName
+			<< '\n';
+	}
+	out.close ();
+	if (out.fail ())
+	{
+		jERR ("Error writing " << tmpFile);
+		unlink (tmpFile.c_str ());
+		return FAIL;
+	}
+
+	if (rename (tmpFile.c_str (), cacheFile) != 0)
+	{
+		jERR ("Unable to rename " << tmpFile << " to " << cacheFile << " : "
+			<< strerror (errno));
+		unlink (tmpFile.c_str ());
+		return FAIL;
+	}
+	return SUCCESS;
+}
+
+//! get method for the number of entries
+unsigned int NameCache::getCount (void)
+{
+	return entries.size ();
+}
+
+//! get method for the entry at pos
+const NameCacheEntry& NameCache::getEntry (unsigned int pos)
+{
+	return entries[pos];
+}
+
+//! \fn int NameCache::findEntry (const string& name, unsigned int nth)
+//! \brief Find the Nth glyph with the name in the cache.
+//! \param [in] name Name of the glyph in the input SFD file.
+//! \param [in] nth Number of glyphs with the same name before it.
+//! \returns Position of the entry, -1 if there is no such glyph.
+int NameCache::findEntry (const string& name, unsigned int nth)
+{
+	unordered_map<string, vector<unsigned int> >::iterator it;
+	it = byName.find (name);
+	if ((it == byName.end ()) || (nth >= it->second.size ()))
+	{
+		return -1;
+	}
+	return it->second[nth];
+}
+
+//! \fn uint64_t NameCache::hashLine (uint64_t hash, string_view line)
+//! \brief Continue the FNV-1a hash with the line and a new line character.
+//! \param [in] hash Hash so far, NAME_HASH_SEED for the first line.
+//! \param [in] line The line.
+//! \returns The new hash.
+uint64_t NameCache::hashLine (uint64_t hash, string_view line)
+{
+	for (size_t i = 0; i < line.size (); i++)
+	{
+		hash ^= (unsigned char) line[i];
+		hash *= 0x100000001b3ULL;
+	}
+	hash ^= '\n';
+	hash *= 0x100000001b3ULL;
+	return hash;
+}
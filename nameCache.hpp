@@ -0,0 +1,61 @@
+#ifndef __NAMECACHE_H
+#define __NAMECACHE_H
+using namespace std;
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+#include "fontClass.hpp"
+//! \file nameCache.hpp
+//! \brief Names resolved by the previous run, for incremental renaming.
+
+//! Extension of the name cache, appended to the output SFD file name.
+#define NAME_CACHE_EXT ".grn"
+
+//! First field of the header line of the name cache.
+#define NAME_CACHE_MAGIC "GRNAMES1"
+
+//! Start value of the glyph fingerprints.
+#define NAME_HASH_SEED 0xcbf29ce484222325ULL
+
+//! A glyph of the previous run.
+struct NameCacheEntry
+{
+	uint64_t fingerprint; //!< Hash of the StartChar, Encoding and Ligature2 lines
+	string curName; //!< Name in the input SFD file
+	string newName; //!< Name given to the glyph, empty if not renamed
+	string builtName; //!< Name built by nameGlyph (), empty if not built
+};
+
+//! The glyphs of the previous run in file order, with the names they
+//! were given. The cache is a text file, a header line holding
+//! NAME_CACHE_MAGIC, the hash of the reference file and the number of
+//! glyphs, followed by one line per glyph with the fingerprint in hex and
+//! the three names, separated by tabs.
+class NameCache
+{
+public:
+	//! Load the cache if it was written with the same reference file.
+	int load (const char *cacheFile, uint64_t refHash);
+
+	//! Write the glyphs and their names to the cache.
+	int save (const char *cacheFile, uint64_t refHash, NameTable& names, GlyphStore& glyphs, vector<int>& nameMap);
+
+	//! Get the number of glyphs in the cache.
+	unsigned int getCount (void);
+
+	//! Get the glyph at pos.
+	const NameCacheEntry& getEntry (unsigned int pos);
+
+	//! Find the Nth glyph with the name, N starting from 0.
+	int findEntry (const string& name, unsigned int nth);
+
+	//! Add the line to the fingerprint.
+	static uint64_t hashLine (uint64_t hash, string_view line);
+private:
+	vector<NameCacheEntry> entries; //!< Glyphs in file order.
+	unordered_map<string, vector<unsigned int> > byName; //!< Entries per name.
+};
+
+#endif
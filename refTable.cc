@@ -0,0 +1,382 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "refTable.hpp"
+#include "sfdTok.hpp"
+#include "fontClass.hpp"
+#include "jlog.hpp"
+//! \file refTable.cc
+//! \brief RefTable implementation
+
+RefTable::RefTable ()
+{
+	clearData ();
+}
+
+//! Empty the table.
+void RefTable::clearData (void)
+{
+	ownCodePts.clear ();
+	ownOffsets.assign (1, 0);
+	ownNames.clear ();
+	cacheBuf.release ();
+
+	codePts = ownCodePts.data ();
+	nameOffsets = ownOffsets.data ();
+	nameBlob = ownNames.data ();
+	count = 0;
+	srcSize = 0;
+	srcHash = 0;
+	lineCount = 0;
+	buildIndex ();
+}
+
+//! \fn void RefTable::buildIndex (void)
+//! \brief Build the paged lookup index over the code point array.
+void RefTable::buildIndex (void)
+{
+	pageDir.clear ();
+	pages.assign (REF_PAGE_SIZE, 0);
+	indexLimit = 0;
+	hasOutliers = false;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if ((codePts[i] < 0) || (codePts[i] > REF_MAX_CODEPT))
+		{
+			hasOutliers = true;
+			continue;
+		}
+
+		uint32_t u = codePts[i];
+		uint32_t dirPos = u / REF_PAGE_SIZE;
+		if (dirPos >= pageDir.size ())
+		{
+			pageDir.resize (dirPos + 1, 0);
+		}
+		if (pageDir[dirPos] == 0)
+		{
+			pageDir[dirPos] = pages.size () / REF_PAGE_SIZE;
+			pages.resize (pages.size () + REF_PAGE_SIZE, 0);
+		}
+		pages[pageDir[dirPos] * REF_PAGE_SIZE + u % REF_PAGE_SIZE] = i + 1;
+	}
+	indexLimit = pageDir.size () * REF_PAGE_SIZE;
+	if (count == 0)
+	{
+		return;
+	}
+	jDBG ("Reference index : " << pageDir.size () << " directory entries, "
+		<< pages.size () / REF_PAGE_SIZE - 1 << " page(s)");
+}
+
+//! \fn uint64_t RefTable::hashData (const char *data, size_t size)
+//! \brief 64 bit FNV-1a hash of the data.
+uint64_t RefTable::hashData (const char *data, size_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= (unsigned char) data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+//! \fn int RefTable::loadText (const char *refFile)
+//! \brief Load the code points and names from the reference file.
+//! Every line holds a code point in hex and the name, separated by a
+//! space. If a code point is listed more than once, the last name is
+//! taken.
+//! \param [in] refFile Name of the reference file.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be read or a line is not valid.
+int RefTable::loadText (const char *refFile)
+{
+	clearData ();
+
+	SfdBuffer stdFile;
+	if (stdFile.loadFile (refFile) != SUCCESS)
+	{
+		jERR ("Unable to read reference file " << refFile);
+		return (FAIL);
+	}
+
+	//! Code point and name of every line, in file order.
+	vector<pair<int, string_view> > entries;
+
+	SfdTokenizer tok;
+	string_view readLine;
+	size_t linePos = 0;
+	while (stdFile.nextLine (linePos, readLine) == SUCCESS)
+	{
+		int codeValue;
+		string_view codeStr;
+		string_view nameStr;
+
+		tok.split (readLine, ' ');
+		// Extract the codepoint value which is the first token and the
+		// glyph name which is the second token.
+		if ((tok.getTok (1, codeStr) != SUCCESS)
+			|| (tok.getTok (2, nameStr) != SUCCESS))
+		{
+			return (FAIL);
+		}
+
+		// Convert hex to int and store.
+		parseHex (codeStr, codeValue);
+		entries.push_back (make_pair (codeValue, nameStr));
+		lineCount++;
+		jTRACE ("Reference entry [" << nameStr << "] " << hex << codeValue
+			<< dec);
+	}
+
+	//! Sort by code point, the later lines stay after the earlier ones.
+	stable_sort (entries.begin (), entries.end (),
+		[] (const pair<int, string_view>& a, const pair<int, string_view>& b)
+		{return a.first < b.first;});
+
+	for (size_t i = 0; i < entries.size (); i++)
+	{
+		if ((i + 1 < entries.size ()) && (entries[i + 1].first == entries[i].first))
+		{
+			continue;
+		}
+		ownCodePts.push_back (entries[i].first);
+		ownNames.append (entries[i].second);
+		ownOffsets.push_back (ownNames.size ());
+	}
+
+	codePts = ownCodePts.data ();
+	nameOffsets = ownOffsets.data ();
+	nameBlob = ownNames.data ();
+	count = ownCodePts.size ();
+	srcSize = stdFile.getSize ();
+	srcHash = hashData (stdFile.getData (), stdFile.getSize ());
+	buildIndex ();
+	return (SUCCESS);
+}
+
+//! \fn int RefTable::loadCache (const char *cacheFile, const char *refFile)
+//! \brief Map the binary cache of the reference file.
+//! The cache is used only if the size and the hash of the reference file
+//! match the ones recorded in the cache. Nothing is parsed, the arrays
+//! point into the mapped file.
+//! \param [in] cacheFile Name of the cache file.
+//! \param [in] refFile Name of the reference file.
+//! \returns SUCCESS if the cache is loaded.
+//! \returns FAIL if the cache is missing, not valid or out of date.
+int RefTable::loadCache (const char *cacheFile, const char *refFile)
+{
+	clearData ();
+
+	if (access (cacheFile, R_OK) != 0)
+	{
+		jDBG ("No reference cache " << cacheFile);
+		return FAIL;
+	}
+
+	SfdBuffer refBuf;
+	if ((refBuf.loadFile (refFile) != SUCCESS)
+		|| (cacheBuf.loadFile (cacheFile) != SUCCESS))
+	{
+		clearData ();
+		return FAIL;
+	}
+
+	const char *data = cacheBuf.getData ();
+	size_t size = cacheBuf.getSize ();
+	RefCacheHeader hdr;
+	if (size < sizeof (hdr))
+	{
+		jWARN ("Reference cache " << cacheFile << " is too short, ignored");
+		clearData ();
+		return FAIL;
+	}
+	memcpy (&hdr, data, sizeof (hdr));
+
+	uint64_t expected = sizeof (hdr) + (uint64_t) hdr.count * sizeof (int32_t)
+		+ ((uint64_t) hdr.count + 1) * sizeof (uint32_t) + hdr.nameBytes;
+	if ((memcmp (hdr.magic, REF_CACHE_MAGIC, sizeof (hdr.magic)) != 0)
+		|| (hdr.byteOrder != 0x01020304) || (expected != size))
+	{
+		jWARN ("Reference cache " << cacheFile << " is not valid, ignored");
+		clearData ();
+		return FAIL;
+	}
+
+	if ((hdr.srcSize != refBuf.getSize ())
+		|| (hdr.srcHash != hashData (refBuf.getData (), refBuf.getSize ())))
+	{
+		jLOG ("Reference cache " << cacheFile << " is out of date, ignored");
+		clearData ();
+		return FAIL;
+	}
+
+	const int32_t *tCodePts = (const int32_t *) (data + sizeof (hdr));
+	const uint32_t *tOffsets = (const uint32_t *) (tCodePts + hdr.count);
+	const char *tNames = (const char *) (tOffsets + hdr.count + 1);
+
+	//! Make sure that the lookups stay within the file.
+	for (uint32_t i = 0; i < hdr.count; i++)
+	{
+		if ((tOffsets[i] > tOffsets[i + 1])
+			|| ((i > 0) && (tCodePts[i - 1] >= tCodePts[i])))
+		{
+			jWARN ("Reference cache " << cacheFile << " is not valid, ignored");
+			clearData ();
+			return FAIL;
+		}
+	}
+	if ((tOffsets[0] != 0) || (tOffsets[hdr.count] != hdr.nameBytes))
+	{
+		jWARN ("Reference cache " << cacheFile << " is not valid, ignored");
+		clearData ();
+		return FAIL;
+	}
+
+	codePts = tCodePts;
+	nameOffsets = tOffsets;
+	nameBlob = tNames;
+	count = hdr.count;
+	srcSize = hdr.srcSize;
+	srcHash = hdr.srcHash;
+	buildIndex ();
+	jDBG ("Loaded " << count << " code points from " << cacheFile);
+	return SUCCESS;
+}
+
+//! \fn int RefTable::writeCache (const char *cacheFile)
+//! \brief Write the table to the binary cache file.
+//! The file is written under a temporary name and renamed, so that a
+//! concurrent run never maps a partly written cache.
+//! \param [in] cacheFile Name of the cache file.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be written.
+int RefTable::writeCache (const char *cacheFile)
+{
+	RefCacheHeader hdr;
+	memset (&hdr, 0, sizeof (hdr));
+	memcpy (hdr.magic, REF_CACHE_MAGIC, sizeof (hdr.magic));
+	hdr.byteOrder = 0x01020304;
+	hdr.count = count;
+	hdr.nameBytes = nameOffsets[count];
+	hdr.srcSize = srcSize;
+	hdr.srcHash = srcHash;
+
+	string tmpFile = string (cacheFile) + ".tmp";
+	ofstream out (tmpFile, ios::binary);
+	if (! out.is_open ())
+	{
+		jERR ("Unable to open " << tmpFile);
+		return FAIL;
+	}
+	out.write ((const char *) &hdr, sizeof (hdr));
+	out.write ((const char *) codePts, count * sizeof (int32_t));
+	out.write ((const char *) nameOffsets, (count + 1) * sizeof (uint32_t));
+	out.write (nameBlob, hdr.nameBytes);
+	out.close ();
+	if (out.fail ())
+	{
+		jERR ("Error writing " << tmpFile);
+		unlink (tmpFile.c_str ());
+		return FAIL;
+	}
+
+	if (rename (tmpFile.c_str (), cacheFile) != 0)
+	{
+		jERR ("Unable to rename " << tmpFile << " to " << cacheFile << " : "
+			<< strerror (errno));
+		unlink (tmpFile.c_str ());
+		return FAIL;
+	}
+	return SUCCESS;
+}
+
+//! \fn int RefTable::find (int codePt, string_view& name) const
+//! \brief Find the name for the code point.
+//! \param [in] codePt The code point.
+//! \param [out] name The name, valid as long as the table.
+//! \returns SUCCESS if the code point is in the table.
+//! \returns FAIL if it is not.
+int RefTable::find (int codePt, string_view& name) const
+{
+	uint32_t u = codePt;
+	if (u < indexLimit)
+	{
+		uint32_t slot = pages[pageDir[u / REF_PAGE_SIZE] * REF_PAGE_SIZE
+			+ u % REF_PAGE_SIZE];
+		if (slot == 0)
+		{
+			return FAIL;
+		}
+		name = getName (slot - 1);
+		return SUCCESS;
+	}
+
+	//! Code points outside the index, only if the reference file had any.
+	if (!hasOutliers)
+	{
+		return FAIL;
+	}
+	const int32_t *end = codePts + count;
+	const int32_t *pos = lower_bound (codePts, end, codePt);
+	if ((pos == end) || (*pos != codePt))
+	{
+		return FAIL;
+	}
+
+	name = getName (pos - codePts);
+	return SUCCESS;
+}
+
+//! get method for count
+unsigned int RefTable::getCount (void) const
+{
+	return count;
+}
+
+//! Get the code point at pos.
+int RefTable::getCodePt (unsigned int pos) const
+{
+	return codePts[pos];
+}
+
+//! Get the name at pos.
+string_view RefTable::getName (unsigned int pos) const
+{
+	return string_view (nameBlob + nameOffsets[pos],
+		nameOffsets[pos + 1] - nameOffsets[pos]);
+}
+
+//! get method for srcSize
+unsigned long RefTable::getSrcSize (void) const
+{
+	return srcSize;
+}
+
+//! get method for srcHash
+uint64_t RefTable::getSrcHash (void) const
+{
+	return srcHash;
+}
+
+//! get method for lineCount
+unsigned long RefTable::getLineCount (void) const
+{
+	return lineCount;
+}
+
+//! Display the RefTable
+void RefTable::displayData (void) const
+{
+	jTRACE ("RefTable.getCount () " << count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		jTRACE ("RefTable[" << codePts[i] << "] = [" << getName (i) << "]");
+	}
+}
@@ -0,0 +1,116 @@
+#ifndef __REFTABLE_H
+#define __REFTABLE_H
+using namespace std;
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdint.h>
+#include "sfdBuffer.hpp"
+//! \file refTable.hpp
+//! \brief Read only table of the reference names, loaded from the
+//! reference file or from its binary cache.
+
+//! Extension of the binary cache, appended to the reference file name.
+#define REF_CACHE_EXT ".grc"
+
+//! Code points per page of the lookup index.
+#define REF_PAGE_SIZE 256
+
+//! Code points above this are not indexed, they are looked up by binary
+//! search.
+#define REF_MAX_CODEPT 0x10FFFF
+
+//! Magic string at the start of the binary cache.
+#define REF_CACHE_MAGIC "GRREFC1"
+
+//! Header of the binary cache file. It is followed by count code points
+//! (int32_t, ascending), count + 1 offsets into the name blob (uint32_t)
+//! and the name blob itself.
+struct RefCacheHeader
+{
+	char magic[8]; //!< REF_CACHE_MAGIC
+	uint32_t byteOrder; //!< 0x01020304 in the byte order of the writer
+	uint32_t count; //!< Number of code points
+	uint32_t nameBytes; //!< Size of the name blob
+	uint32_t reserved; //!< Zero
+	uint64_t srcSize; //!< Size of the reference file
+	uint64_t srcHash; //!< FNV-1a hash of the reference file
+};
+
+//! Code points and names from the reference file, sorted by code point.
+//! The arrays either point into a mapped cache file or into vectors owned
+//! by the table; the lookups do not care which.
+//!
+//! Lookups go through a two level index. The directory has an entry per
+//! REF_PAGE_SIZE code points, giving the page that holds the position + 1
+//! of each of those code points in the arrays (0 if absent). Pages are
+//! allocated only for the ranges that have entries, the other directory
+//! entries share the empty page 0. The table is not changed by lookups.
+class RefTable
+{
+public:
+	RefTable ();
+	RefTable (const RefTable&) = delete;
+	RefTable& operator= (const RefTable&) = delete;
+
+	//! Parse the reference file.
+	int loadText (const char *refFile);
+
+	//! Map the cache file if it was built from refFile as it is now.
+	int loadCache (const char *cacheFile, const char *refFile);
+
+	//! Write the table to the cache file.
+	int writeCache (const char *cacheFile);
+
+	//! Find the name for the code point.
+	int find (int codePt, string_view& name) const;
+
+	//! Get the number of code points.
+	unsigned int getCount (void) const;
+
+	//! Get the code point at pos.
+	int getCodePt (unsigned int pos) const;
+
+	//! Get the name at pos.
+	string_view getName (unsigned int pos) const;
+
+	//! Get the size of the reference file.
+	unsigned long getSrcSize (void) const;
+
+	//! Get the hash of the reference file.
+	uint64_t getSrcHash (void) const;
+
+	//! Get the number of lines parsed, 0 if loaded from the cache.
+	unsigned long getLineCount (void) const;
+
+	//! Display the RefTable
+	void displayData (void) const;
+
+	//! Hash of the data, used to match the cache with the reference file.
+	static uint64_t hashData (const char *data, size_t size);
+
+private:
+	void clearData (void);
+	void buildIndex (void);
+
+	const int32_t *codePts; //!< Code points, ascending.
+	const uint32_t *nameOffsets; //!< Start of each name, count + 1 entries.
+	const char *nameBlob; //!< The names, without separators.
+	uint32_t count; //!< Number of code points.
+
+	uint64_t srcSize; //!< Size of the reference file.
+	uint64_t srcHash; //!< Hash of the reference file.
+	unsigned long lineCount; //!< Lines parsed by loadText.
+
+	vector<uint32_t> pageDir; //!< Page number per REF_PAGE_SIZE code points.
+	vector<uint32_t> pages; //!< The pages, page 0 is empty.
+	uint32_t indexLimit; //!< Code points below this are in the index.
+	bool hasOutliers; //!< Some code points are outside the index.
+
+	vector<int32_t> ownCodePts; //!< Storage when parsed from text.
+	vector<uint32_t> ownOffsets; //!< Storage when parsed from text.
+	string ownNames; //!< Storage when parsed from text.
+	SfdBuffer cacheBuf; //!< The mapped cache file.
+};
+
+#endif
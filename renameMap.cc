@@ -0,0 +1,205 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "renameMap.hpp"
+#include "sfdBuffer.hpp"
+#include "sfdTok.hpp"
+#include "jlog.hpp"
+//! \file renameMap.cc
+//! \brief RenameMap implementation
+
+//! \fn int RenameMap::load (const char *mapFile)
+//! \brief Load the glyphs renamed by a previous run.
+//! \param [in] mapFile Name of the map file.
+//! \returns SUCCESS if the map is loaded.
+//! \returns FAIL if the map is missing, not valid or not sorted.
+int RenameMap::load (const char *mapFile)
+{
+	entries.clear ();
+	byName.clear ();
+
+	SfdBuffer mapBuf;
+	if (mapBuf.loadFile (mapFile) != SUCCESS)
+	{
+		jERR ("Unable to load rename map " << mapFile);
+		return FAIL;
+	}
+
+	SfdTokenizer tok;
+	string_view line;
+	string_view field;
+	size_t pos = 0;
+	unsigned long count = 0;
+	if ((mapBuf.nextLine (pos, line) != SUCCESS)
+		|| (tok.split (line, '\t') != 2)
+		|| (tok.getTok (1, field) != SUCCESS) || (field != RENAME_MAP_MAGIC))
+	{
+		jERR ("Rename map " << mapFile << " is not valid");
+		return FAIL;
+	}
+	tok.getTok (2, field);
+	count = strtoul (string (field).c_str (), NULL, 10);
+	entries.reserve (count);
+
+	int lineNo = 1;
+	while (mapBuf.nextLine (pos, line) == SUCCESS)
+	{
+		lineNo++;
+		RenameMapEntry entry;
+		if ((tok.split (line, '\t') != 2) || (tok.getTok (1, field) != SUCCESS)
+			|| field.empty ())
+		{
+			jERR (mapFile << ":" << lineNo << " : Expected old and new glyph"
+				" names separated by a tab");
+			entries.clear ();
+			return FAIL;
+		}
+		entry.oldName = field;
+		tok.getTok (2, field);
+		entry.newName = field;
+
+		//! The old names are sorted and unique, a name is renamed once.
+		if (!entries.empty () && (entries.back ().oldName >= entry.oldName))
+		{
+			jERR (mapFile << ":" << lineNo << " : [" << entry.oldName
+				<< "] is not in sorted order or listed twice");
+			entries.clear ();
+			return FAIL;
+		}
+		entries.push_back (entry);
+	}
+
+	if (entries.size () != count)
+	{
+		jERR ("Rename map " << mapFile << " is truncated");
+		entries.clear ();
+		return FAIL;
+	}
+
+	//! The index refers to the strings of the entries, it is built once
+	//! they are all in place.
+	byName.reserve (entries.size ());
+	for (unsigned int i = 0; i < entries.size (); i++)
+	{
+		byName[entries[i].oldName] = i;
+	}
+	jDBG ("Loaded " << count << " glyph(s) from " << mapFile);
+	return SUCCESS;
+}
+
+//! \fn int RenameMap::save (const char *mapFile, NameTable& names, vector<int>& nameMap)
+//! \brief Write the glyphs renamed by the run to the map.
+//! The file is written under a temporary name and renamed, an interrupted
+//! run leaves the previous map in place.
+//! \param [in] mapFile Name of the map file.
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] nameMap The rename map, indexed by the old name ID.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be written.
+int RenameMap::save (const char *mapFile, NameTable& names, vector<int>& nameMap)
+{
+	vector<int> renamed;
+	for (unsigned int i = 0; i < nameMap.size (); i++)
+	{
+		if ((nameMap[i] != NO_NAME) && (nameMap[i] != (int) i))
+		{
+			renamed.push_back (i);
+		}
+	}
+	sort (renamed.begin (), renamed.end (),
+		[&names] (int a, int b) {return names.getName (a) < names.getName (b);});
+
+	string tmpFile = string (mapFile) + ".tmp";
+	ofstream out (tmpFile, ios::binary);
+	if (! out.is_open ())
+	{
+		jERR ("Unable to open " << tmpFile);
+		return FAIL;
+	}
+
+	out << RENAME_MAP_MAGIC << '\t' << renamed.size () << '\n';
+	for (unsigned int i = 0; i < renamed.size (); i++)
+	{
+		const string& oldName = names.getName (renamed[i]);
+		const string& newName = names.getName (nameMap[renamed[i]]);
+		if ((oldName.find_first_of ("\t\n") != string::npos)
+			|| (newName.find_first_of ("\t\n") != string::npos))
+		{
+			jERR ("Glyph name [" << oldName
+				<< "] cannot be written to the rename map");
+			out.close ();
+			unlink (tmpFile.c_str ());
+			return FAIL;
+		}
+		out << oldName << '\t' << newName << '\n';
+	}
+	out.close ();
+	if (out.fail ())
+	{
+		jERR ("Error writing " << tmpFile);
+		unlink (tmpFile.c_str ());
+		return FAIL;
+	}
+
+	if (rename (tmpFile.c_str (), mapFile) != 0)
+	{
+		jERR ("Unable to rename " << tmpFile << " to " << mapFile << " : "
+			<< strerror (errno));
+		unlink (tmpFile.c_str ());
+		return FAIL;
+	}
+	jLOG ("Wrote " << renamed.size () << " glyph(s) to " << mapFile);
+	return SUCCESS;
+}
+
+//! get method for the number of entries
+unsigned int RenameMap::getCount (void) const
+{
+	return entries.size ();
+}
+
+//! \fn const string *RenameMap::findName (string_view oldName) const
+//! \brief Find the new name of the glyph.
+//! \param [in] oldName Name of the glyph in the input file.
+//! \returns The new name, NULL if the glyph is not renamed.
+const string *RenameMap::findName (string_view oldName) const
+{
+	unordered_map<string_view, unsigned int>::const_iterator it;
+	it = byName.find (oldName);
+	if (it == byName.end ())
+	{
+		return NULL;
+	}
+	return &entries[it->second].newName;
+}
+
+//! \fn int RenameMap::buildMap (NameTable& names, vector<int>& nameMap, int& renCount) const
+//! \brief Build the rename map of the names in the symbol table.
+//! The new names are added to the symbol table.
+//! \param [in,out] names Symbol table of the glyph names.
+//! \param [out] nameMap The rename map, indexed by the old name ID. Names
+//! not in the map are not renamed, NO_NAME.
+//! \param [out] renCount Number of names renamed.
+//! \returns SUCCESS
+int RenameMap::buildMap (NameTable& names, vector<int>& nameMap,
+	int& renCount) const
+{
+	unsigned int nameCount = names.getCount ();
+	nameMap.assign (nameCount, NO_NAME);
+	renCount = 0;
+	for (unsigned int i = 0; i < nameCount; i++)
+	{
+		const string *newName = findName (names.getName (i));
+		if (newName != NULL)
+		{
+			nameMap[i] = names.intern (*newName);
+			renCount++;
+		}
+	}
+	return SUCCESS;
+}
@@ -0,0 +1,48 @@
+#ifndef __RENAMEMAP_H
+#define __RENAMEMAP_H
+using namespace std;
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "fontClass.hpp"
+//! \file renameMap.hpp
+//! \brief Old and new glyph names of a run, to rename other files alike.
+
+//! First field of the header line of the rename map.
+#define RENAME_MAP_MAGIC "GRMAP1"
+
+//! A glyph renamed by the run.
+struct RenameMapEntry
+{
+	string oldName; //!< Name in the input SFD file
+	string newName; //!< Name given to the glyph
+};
+
+//! The glyphs renamed by a run, sorted by the old name. The map is a text
+//! file, a header line holding RENAME_MAP_MAGIC and the number of glyphs,
+//! followed by one line per glyph with the old and the new name separated
+//! by a tab. Glyphs that keep their name are not listed.
+class RenameMap
+{
+public:
+	//! Load the map written by save ().
+	int load (const char *mapFile);
+
+	//! Write the glyphs renamed by the run to the map.
+	int save (const char *mapFile, NameTable& names, vector<int>& nameMap);
+
+	//! Get the number of glyphs in the map.
+	unsigned int getCount (void) const;
+
+	//! Get the new name of the glyph, NULL if it is not renamed.
+	const string *findName (string_view oldName) const;
+
+	//! Build the rename map of the names in the symbol table.
+	int buildMap (NameTable& names, vector<int>& nameMap, int& renCount) const;
+private:
+	vector<RenameMapEntry> entries; //!< Glyphs sorted by the old name.
+	unordered_map<string_view, unsigned int> byName; //!< Entry of the old names.
+};
+
+#endif
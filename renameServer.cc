@@ -0,0 +1,474 @@
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "renameServer.hpp"
+#include "threadPool.hpp"
+#include "jlog.hpp"
+//! \file renameServer.cc
+//! \brief RenameServer implementation
+
+//! Set by SIGINT and SIGTERM.
+static volatile sig_atomic_t ServeSignal = 0;
+
+//! The listening socket, shut down by the signal handler.
+static int ServeListenFd = -1;
+
+//! \fn static void serveSignal (int sig)
+//! \brief Stop accepting connections, run () takes it from there.
+static void serveSignal (int sig)
+{
+	ServeSignal = sig;
+	if (ServeListenFd >= 0)
+	{
+		shutdown (ServeListenFd, SHUT_RDWR);
+	}
+}
+
+//! \fn static int readLine (int fd, string& pending, string& line)
+//! \brief Read a line from the connection.
+//! \param [in] fd The connection.
+//! \param [in,out] pending Data read but not used yet, the line and the
+//! new line are removed from it.
+//! \param [out] line The line, without the new line.
+//! \returns SUCCESS if a line is read.
+//! \returns FAIL at the end of the connection or if the line is too long.
+static int readLine (int fd, string& pending, string& line)
+{
+	char chunk[65536];
+	size_t scanned = 0;
+	while (true)
+	{
+		size_t nl = pending.find ('\n', scanned);
+		if (nl != string::npos)
+		{
+			line.assign (pending, 0, nl);
+			pending.erase (0, nl + 1);
+			return SUCCESS;
+		}
+		if (pending.size () > SERVE_MAX_LINE)
+		{
+			jERR ("Request longer than " << SERVE_MAX_LINE << " bytes");
+			return FAIL;
+		}
+		scanned = pending.size ();
+
+		ssize_t n = read (fd, chunk, sizeof (chunk));
+		if ((n < 0) && (errno == EINTR))
+		{
+			continue;
+		}
+		if (n <= 0)
+		{
+			return FAIL;
+		}
+		pending.append (chunk, n);
+	}
+}
+
+//! \fn static int readPayload (int fd, string& pending, size_t length, int outFd)
+//! \brief Copy the data following a request to a file.
+//! \param [in] fd The connection.
+//! \param [in,out] pending Data read but not used yet, the data copied is
+//! removed from it.
+//! \param [in] length Bytes to copy.
+//! \param [in] outFd The file.
+//! \returns SUCCESS if all the data is copied.
+//! \returns FAIL if the connection ends early or the file cannot be written.
+static int readPayload (int fd, string& pending, size_t length, int outFd)
+{
+	vector<struct iovec> segments;
+	size_t written;
+
+	size_t fromPending = min (length, pending.size ());
+	addSegment (segments, pending.data (), fromPending);
+	if (writeSegments (outFd, segments, written) != SUCCESS)
+	{
+		return FAIL;
+	}
+	pending.erase (0, fromPending);
+	length -= fromPending;
+
+	char chunk[65536];
+	while (length > 0)
+	{
+		ssize_t n = read (fd, chunk, min (sizeof (chunk), length));
+		if ((n < 0) && (errno == EINTR))
+		{
+			continue;
+		}
+		if (n <= 0)
+		{
+			return FAIL;
+		}
+		segments.clear ();
+		addSegment (segments, chunk, n);
+		if (writeSegments (outFd, segments, written) != SUCCESS)
+		{
+			return FAIL;
+		}
+		length -= n;
+	}
+	return SUCCESS;
+}
+
+//! \fn static int sendAll (int fd, const string& data)
+//! \brief Send the whole string over the connection.
+static int sendAll (int fd, const string& data)
+{
+	const char *buf = data.data ();
+	size_t length = data.size ();
+	while (length > 0)
+	{
+		ssize_t n = send (fd, buf, length, MSG_NOSIGNAL);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return FAIL;
+		}
+		buf += n;
+		length -= n;
+	}
+	return SUCCESS;
+}
+
+//! \fn static int sendFile (int fd, int inFd, size_t length)
+//! \brief Send the file from its start over the connection.
+static int sendFile (int fd, int inFd, size_t length)
+{
+	off_t offset = 0;
+	while (length > 0)
+	{
+		ssize_t n = sendfile (fd, inFd, &offset, length);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return FAIL;
+		}
+		if (n == 0)
+		{
+			return FAIL;
+		}
+		length -= n;
+	}
+	return SUCCESS;
+}
+
+RenameServer::RenameServer (RenameFunc renameFunc,
+	const RenameOptions& options)
+	: renameFunc (renameFunc), options (options)
+{
+	listenFd = -1;
+	stopping = false;
+}
+
+//! \fn int RenameServer::run (const char *socketPath, unsigned int workerCount)
+//! \brief Accept connections and serve them until stopped.
+//! A connection is served by one worker for as long as it is open, more
+//! than workerCount clients wait for a worker to be free.
+//! \param [in] socketPath Path of the Unix domain socket.
+//! \param [in] workerCount Number of connections served in parallel.
+//! \returns SUCCESS if the server stopped on request.
+//! \returns FAIL if the socket cannot be created or accept () failed.
+int RenameServer::run (const char *socketPath, unsigned int workerCount)
+{
+	if (openSocket (socketPath) != SUCCESS)
+	{
+		return FAIL;
+	}
+
+	//! A client closing the connection early must not end the server.
+	signal (SIGPIPE, SIG_IGN);
+	struct sigaction sa;
+	memset (&sa, 0, sizeof (sa));
+	sa.sa_handler = serveSignal;
+	sigemptyset (&sa.sa_mask);
+	ServeListenFd = listenFd;
+	sigaction (SIGINT, &sa, NULL);
+	sigaction (SIGTERM, &sa, NULL);
+
+	jLOG ("Serving on " << socketPath << " using " << workerCount
+		<< " thread(s)");
+	int retVal = SUCCESS;
+	{
+		ThreadPool pool (workerCount);
+		while (true)
+		{
+			int clientFd = accept4 (listenFd, NULL, NULL, SOCK_CLOEXEC);
+			if (clientFd < 0)
+			{
+				if (ServeSignal != 0)
+				{
+					jLOG ("Stopping on signal " << ServeSignal);
+					break;
+				}
+				if ((errno == EINTR) || (errno == ECONNABORTED))
+				{
+					continue;
+				}
+				lock_guard<mutex> lk (clientLock);
+				if (!stopping)
+				{
+					jERR ("Unable to accept on " << socketPath << " : "
+						<< strerror (errno));
+					retVal = FAIL;
+				}
+				break;
+			}
+
+			{
+				lock_guard<mutex> lk (clientLock);
+				if (stopping)
+				{
+					close (clientFd);
+					break;
+				}
+				clients.insert (clientFd);
+			}
+			pool.submit ([this, clientFd] () {serveClient (clientFd);});
+		}
+		stop ();
+		pool.wait ();
+	}
+
+	ServeListenFd = -1;
+	close (listenFd);
+	listenFd = -1;
+	unlink (socketPath);
+	jLOG ("Stopped serving on " << socketPath);
+	return retVal;
+}
+
+//! \fn int RenameServer::openSocket (const char *socketPath)
+//! \brief Create the socket, only the user running the server can
+//! connect. A socket left behind by a server that is not running is
+//! replaced.
+//! \param [in] socketPath Path of the socket.
+//! \returns SUCCESS if the server is listening.
+//! \returns FAIL if the path is in use or the socket cannot be created.
+int RenameServer::openSocket (const char *socketPath)
+{
+	struct sockaddr_un addr;
+	memset (&addr, 0, sizeof (addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen (socketPath) >= sizeof (addr.sun_path))
+	{
+		jERR ("Socket path " << socketPath << " is too long");
+		return FAIL;
+	}
+	strcpy (addr.sun_path, socketPath);
+
+	struct stat st;
+	if (lstat (socketPath, &st) == 0)
+	{
+		if (!S_ISSOCK (st.st_mode))
+		{
+			jERR (socketPath << " exists and is not a socket");
+			return FAIL;
+		}
+		int probeFd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		int inUse = (probeFd >= 0)
+			&& (connect (probeFd, (struct sockaddr *) &addr, sizeof (addr)) == 0);
+		if (probeFd >= 0)
+		{
+			close (probeFd);
+		}
+		if (inUse)
+		{
+			jERR ("A server is already running on " << socketPath);
+			return FAIL;
+		}
+		unlink (socketPath);
+	}
+
+	listenFd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listenFd < 0)
+	{
+		jERR ("Unable to create socket : " << strerror (errno));
+		return FAIL;
+	}
+	mode_t oldMask = umask (0077);
+	int retVal = bind (listenFd, (struct sockaddr *) &addr, sizeof (addr));
+	umask (oldMask);
+	if ((retVal != 0) || (listen (listenFd, SOMAXCONN) != 0))
+	{
+		jERR ("Unable to listen on " << socketPath << " : " << strerror (errno));
+		close (listenFd);
+		listenFd = -1;
+		return FAIL;
+	}
+	return SUCCESS;
+}
+
+//! \fn void RenameServer::serveClient (int clientFd)
+//! \brief Read the requests of a connection and reply to them. The
+//! connection is closed at the end, or after a request that cannot be
+//! read.
+//! \param [in] clientFd The connection.
+void RenameServer::serveClient (int clientFd)
+{
+	string pending;
+	string request;
+	SfdTokenizer tok;
+	while (readLine (clientFd, pending, request) == SUCCESS)
+	{
+		string_view command = string_view (request).substr (0,
+			request.find ('\t'));
+		int retVal;
+		if (command == SERVE_RENAME)
+		{
+			retVal = handleRename (clientFd, pending, tok, request);
+		}
+		else if (command == SERVE_SHUTDOWN)
+		{
+			jLOG ("Shutdown requested");
+			retVal = sendAll (clientFd, string (SERVE_OK) + "\n");
+			stop ();
+		}
+		else
+		{
+			sendAll (clientFd, string (SERVE_ERR) + "\tUnknown request\n");
+			retVal = FAIL;
+		}
+		if (retVal != SUCCESS)
+		{
+			break;
+		}
+	}
+
+	lock_guard<mutex> lk (clientLock);
+	clients.erase (clientFd);
+	close (clientFd);
+}
+
+//! \fn int RenameServer::handleRename (int clientFd, string& pending, SfdTokenizer& tok, const string& request)
+//! \brief Rename a font and send the reply.
+//! SFD data sent with the request is kept in an anonymous memory file,
+//! output to be sent back is written to another one, so the renaming is
+//! the same as for files.
+//! \param [in] clientFd The connection.
+//! \param [in,out] pending Data read but not used yet.
+//! \param [in] tok Tokenizer for the request.
+//! \param [in] request The request line.
+//! \returns SUCCESS if the reply is sent, the font may not be renamed.
+//! \returns FAIL if the request is not valid or the connection failed.
+int RenameServer::handleRename (int clientFd, string& pending,
+	SfdTokenizer& tok, const string& request)
+{
+	string_view field;
+	unsigned int fieldCount = tok.split (request, '\t');
+	if ((fieldCount < 3) || (fieldCount > 4))
+	{
+		sendAll (clientFd, string (SERVE_ERR)
+			+ "\tExpected RENAME, input, output and the input length\n");
+		return FAIL;
+	}
+	tok.getTok (2, field);
+	string inFile (field);
+	tok.getTok (3, field);
+	string outFile (field);
+
+	RenameOptions jobOpts = options;
+	int retVal = SUCCESS;
+	if (inFile == STDIO_NAME)
+	{
+		if (tok.getTok (4, field) != SUCCESS)
+		{
+			sendAll (clientFd, string (SERVE_ERR)
+				+ "\tThe length of the input is missing\n");
+			return FAIL;
+		}
+		size_t length = strtoull (string (field).c_str (), NULL, 10);
+		jobOpts.inFd = memfd_create ("glyphRen-in", MFD_CLOEXEC);
+		if ((jobOpts.inFd < 0)
+			|| (readPayload (clientFd, pending, length, jobOpts.inFd) != SUCCESS))
+		{
+			jERR ("Unable to read the input of the request : "
+				<< strerror (errno));
+			retVal = FAIL;
+		}
+	}
+	else if (fieldCount == 4)
+	{
+		sendAll (clientFd, string (SERVE_ERR)
+			+ "\tThe input length is only given for -\n");
+		return FAIL;
+	}
+
+	//! The name cache is kept next to an output file.
+	if ((retVal == SUCCESS) && (outFile == STDIO_NAME))
+	{
+		jobOpts.useCache = false;
+		jobOpts.outFd = memfd_create ("glyphRen-out", MFD_CLOEXEC);
+		if (jobOpts.outFd < 0)
+		{
+			jERR ("Unable to buffer the output : " << strerror (errno));
+			retVal = FAIL;
+		}
+	}
+
+	ostringstream reply;
+	RenameStats stats;
+	if (retVal == SUCCESS)
+	{
+		jLOG ("Renaming " << inFile << " to " << outFile);
+		if (renameFunc (inFile, outFile, jobOpts, stats) == SUCCESS)
+		{
+			reply << SERVE_OK << '\t' << stats.renamed << '\t'
+				<< ((jobOpts.outFd >= 0) ? stats.outBytes : 0) << '\n';
+		}
+		else
+		{
+			reply << SERVE_ERR << "\tUnable to rename " << inFile << '\n';
+			stats.outBytes = 0;
+		}
+		retVal = sendAll (clientFd, reply.str ());
+		if ((retVal == SUCCESS) && (jobOpts.outFd >= 0) && (stats.outBytes > 0))
+		{
+			retVal = sendFile (clientFd, jobOpts.outFd, stats.outBytes);
+		}
+	}
+
+	if (jobOpts.inFd >= 0)
+	{
+		close (jobOpts.inFd);
+	}
+	if (jobOpts.outFd >= 0)
+	{
+		close (jobOpts.outFd);
+	}
+	return retVal;
+}
+
+//! \fn void RenameServer::stop (void)
+//! \brief Stop accepting connections. The open connections are shut
+//! down for reading, the requests being served are finished and replied
+//! to.
+void RenameServer::stop (void)
+{
+	lock_guard<mutex> lk (clientLock);
+	stopping = true;
+	if (listenFd >= 0)
+	{
+		shutdown (listenFd, SHUT_RDWR);
+	}
+	for (int fd : clients)
+	{
+		shutdown (fd, SHUT_RD);
+	}
+}
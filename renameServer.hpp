@@ -0,0 +1,79 @@
+#ifndef __RENAMESERVER_H
+#define __RENAMESERVER_H
+using namespace std;
+#include <string>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include "sfdRename.hpp"
+//! \file renameServer.hpp
+//! \brief Resident server renaming fonts for clients over a Unix socket.
+//!
+//! A client sends requests of one line each, the fields separated by
+//! tabs, and gets a reply line for each:
+//!
+//!	RENAME inFile outFile [inLength]
+//!		inFile - : inLength bytes of SFD data follow the line.
+//!		outFile - : the output follows the reply line.
+//!		Reply : OK renamed outLength, followed by outLength bytes of
+//!		output for outFile -, or ERR message.
+//!	SHUTDOWN
+//!		Reply : OK, the server stops once the open connections close.
+//!
+//! Any number of requests can be sent over a connection. The file names
+//! are opened by the server, relative names are taken from the working
+//! directory of the server.
+
+//! Request to rename a font.
+#define SERVE_RENAME "RENAME"
+
+//! Request to stop the server.
+#define SERVE_SHUTDOWN "SHUTDOWN"
+
+//! Reply to a request that succeeded.
+#define SERVE_OK "OK"
+
+//! Reply to a request that failed, followed by the reason.
+#define SERVE_ERR "ERR"
+
+//! Longest request line accepted, in bytes.
+#define SERVE_MAX_LINE 16384
+
+//! Renames a font, renameFont () or applyRenameMap () with the data they
+//! share bound in.
+typedef function<int (const string& inFile, const string& outFile, const RenameOptions& options, RenameStats& stats)> RenameFunc;
+
+//! Accepts connections on a Unix domain socket and renames the fonts
+//! requested by the clients. The reference data stays loaded between the
+//! requests, every connection is served by a worker of a ThreadPool.
+class RenameServer
+{
+public:
+	RenameServer (RenameFunc renameFunc, const RenameOptions& options);
+	RenameServer (const RenameServer&) = delete;
+	RenameServer& operator= (const RenameServer&) = delete;
+
+	//! Serve the clients until SHUTDOWN, SIGINT or SIGTERM.
+	int run (const char *socketPath, unsigned int workerCount);
+private:
+	//! Create the socket and listen on it.
+	int openSocket (const char *socketPath);
+
+	//! Serve the requests of a connection until it is closed.
+	void serveClient (int clientFd);
+
+	//! Rename a font for a RENAME request and send the reply.
+	int handleRename (int clientFd, string& pending, SfdTokenizer& tok, const string& request);
+
+	//! Stop accepting connections and end the open ones.
+	void stop (void);
+
+	RenameFunc renameFunc; //!< Renames a font.
+	RenameOptions options; //!< Options for every font.
+	int listenFd; //!< The listening socket.
+	mutex clientLock; //!< Protects clients and stopping.
+	unordered_set<int> clients; //!< Open connections.
+	bool stopping; //!< SHUTDOWN was requested.
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include <iomanip>
+#include <stdio.h>
+#include "runStats.hpp"
+#include "fontClass.hpp"
+//! \file runStats.cc
+//! \brief Report of the time and counters of the phases.
+
+//! Milliseconds from start to end.
+static double msBetween (const struct timespec& start, const struct timespec& end)
+{
+	return (end.tv_sec - start.tv_sec) * 1000.0
+		+ (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+//! Start the timer.
+PhaseTimer::PhaseTimer ()
+{
+	clock_gettime (CLOCK_MONOTONIC, &wallStart);
+	clock_gettime (CLOCK_THREAD_CPUTIME_ID, &cpuStart);
+}
+
+//! \fn void PhaseTimer::stop (PhaseStats& phase)
+//! \brief Add the time since the timer was started to the phase.
+//! \param [in,out] phase The phase.
+void PhaseTimer::stop (PhaseStats& phase)
+{
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	phase.wallMs += msBetween (wallStart, now);
+	clock_gettime (CLOCK_THREAD_CPUTIME_ID, &now);
+	phase.cpuMs += msBetween (cpuStart, now);
+}
+
+//! Write a row of the phase table.
+static void printPhaseRow (ostream& out, const char *name, const PhaseStats& phase)
+{
+	char row[128];
+	snprintf (row, sizeof (row), "%-10s %12.3f %12.3f %14lu %10lu\n", name,
+		phase.wallMs, phase.cpuMs, phase.bytes, phase.lines);
+	out << row;
+}
+
+//! Write the header of the phase table.
+static void printPhaseHeader (ostream& out)
+{
+	char row[128];
+	snprintf (row, sizeof (row), "%-10s %12s %12s %14s %10s\n", "Phase",
+		"Wall ms", "CPU ms", "Bytes", "Lines");
+	out << row;
+}
+
+//! \fn void printRefStatsText (ostream& out, const string& refFile, const PhaseStats& ref)
+//! \brief Write the statistics of loading the reference file as a table.
+//! \param [in] out The stream.
+//! \param [in] refFile Name of the reference file.
+//! \param [in] ref Statistics of loading the reference file.
+void printRefStatsText (ostream& out, const string& refFile, const PhaseStats& ref)
+{
+	out << "Reference file " << refFile << "\n";
+	printPhaseHeader (out);
+	printPhaseRow (out, "reference", ref);
+	out << "\n";
+}
+
+//! \fn void printStatsText (ostream& out, const string& inFile, int result, const RenameStats& stats)
+//! \brief Write the statistics of renaming a font as a table.
+//! \param [in] out The stream.
+//! \param [in] inFile Name of the input SFD file.
+//! \param [in] result SUCCESS if the font was renamed.
+//! \param [in] stats Statistics of the font.
+void printStatsText (ostream& out, const string& inFile, int result, const RenameStats& stats)
+{
+	PhaseStats total;
+	const PhaseStats *phases[] = {&stats.analyze, &stats.rename, &stats.write};
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		total.wallMs += phases[i]->wallMs;
+		total.cpuMs += phases[i]->cpuMs;
+		total.bytes += phases[i]->bytes;
+		total.lines += phases[i]->lines;
+	}
+
+	out << "SFD file " << inFile << ((result == SUCCESS) ? "" : " (failed)")
+		<< "\n";
+	printPhaseHeader (out);
+	printPhaseRow (out, "analyze", stats.analyze);
+	printPhaseRow (out, "rename", stats.rename);
+	printPhaseRow (out, "write", stats.write);
+	printPhaseRow (out, "total", total);
+	out << "Glyphs           : " << stats.glyphs << "\n";
+	out << "Ligatures        : " << stats.ligatures << "\n";
+	out << "Parse chunks     : " << stats.chunks << "\n";
+	out << "Glyphs renamed   : " << stats.renamed << "\n";
+	out << "Rename passes    : " << stats.passes << "\n";
+	out << "checkDups calls  : " << stats.dupChecks << "\n";
+	out << "Suffix retries   : " << stats.suffixRetries << "\n";
+	out << "Output bytes     : " << stats.outBytes << "\n";
+	out << "Names reused     : " << stats.reused << "\n";
+	out << "Duplicate input  : " << stats.dupInput << "\n";
+	out << "Duplicate output : " << stats.dupOutput << "\n";
+	out << "\n";
+}
+
+//! \fn void printJsonString (ostream& out, const string& str)
+//! \brief Write the string as a JSON string, quoted and escaped.
+//! \param [in] out The stream.
+//! \param [in] str The string.
+void printJsonString (ostream& out, const string& str)
+{
+	out << '"';
+	for (unsigned int i = 0; i < str.size (); i++)
+	{
+		unsigned char c = str[i];
+		if ((c == '"') || (c == '\\'))
+		{
+			out << '\\' << c;
+		}
+		else if (c < 0x20)
+		{
+			char esc[8];
+			snprintf (esc, sizeof (esc), "\\u%04x", c);
+			out << esc;
+		}
+		else
+		{
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+//! Write the phase as a JSON object.
+static void printPhaseJson (ostream& out, const PhaseStats& phase)
+{
+	out << "{\"wall_ms\": " << phase.wallMs << ", \"cpu_ms\": " << phase.cpuMs
+		<< ", \"bytes\": " << phase.bytes << ", \"lines\": " << phase.lines << "}";
+}
+
+//! \fn void printRefStatsJson (ostream& out, const string& refFile, const PhaseStats& ref)
+//! \brief Start the JSON report with the statistics of the reference file.
+//! The fonts follow in the "fonts" array, printStatsJsonEnd () closes it.
+//! \param [in] out The stream.
+//! \param [in] refFile Name of the reference file.
+//! \param [in] ref Statistics of loading the reference file.
+void printRefStatsJson (ostream& out, const string& refFile, const PhaseStats& ref)
+{
+	out << fixed << setprecision (3);
+	out << "{\n  \"reference\": {\"file\": ";
+	printJsonString (out, refFile);
+	out << ", \"load\": ";
+	printPhaseJson (out, ref);
+	out << "},\n  \"fonts\": [";
+}
+
+//! \fn void printStatsJson (ostream& out, const string& inFile, const string& outFile, int result, const RenameStats& stats, bool first)
+//! \brief Write the statistics of renaming a font as a JSON object.
+//! \param [in] out The stream.
+//! \param [in] inFile Name of the input SFD file.
+//! \param [in] outFile Name of the output SFD file.
+//! \param [in] result SUCCESS if the font was renamed.
+//! \param [in] stats Statistics of the font.
+//! \param [in] first true for the first font in the array.
+void printStatsJson (ostream& out, const string& inFile, const string& outFile,
+	int result, const RenameStats& stats, bool first)
+{
+	out << (first ? "\n" : ",\n") << "    {\"input\": ";
+	printJsonString (out, inFile);
+	out << ", \"output\": ";
+	printJsonString (out, outFile);
+	out << ", \"success\": " << ((result == SUCCESS) ? "true" : "false");
+	out << ",\n     \"phases\": {\"analyze\": ";
+	printPhaseJson (out, stats.analyze);
+	out << ",\n                \"rename\": ";
+	printPhaseJson (out, stats.rename);
+	out << ",\n                \"write\": ";
+	printPhaseJson (out, stats.write);
+	out << "},\n     \"glyphs\": " << stats.glyphs
+		<< ", \"ligatures\": " << stats.ligatures
+		<< ", \"chunks\": " << stats.chunks
+		<< ", \"renamed\": " << stats.renamed
+		<< ", \"passes\": " << stats.passes
+		<< ", \"dup_checks\": " << stats.dupChecks
+		<< ", \"suffix_retries\": " << stats.suffixRetries
+		<< ", \"output_bytes\": " << stats.outBytes
+		<< ", \"reused\": " << stats.reused
+		<< ", \"dup_input\": " << stats.dupInput
+		<< ", \"dup_output\": " << stats.dupOutput << "}";
+}
+
+//! Close the JSON report.
+void printStatsJsonEnd (ostream& out)
+{
+	out << "\n  ]\n}\n";
+}
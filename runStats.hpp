@@ -0,0 +1,70 @@
+#ifndef __RUNSTATS_H
+#define __RUNSTATS_H
+using namespace std;
+#include <string>
+#include <ostream>
+#include <time.h>
+//! \file runStats.hpp
+//! \brief Time and counters of the phases of a run, for --stats.
+
+//! Time taken and data read or written by a phase.
+struct PhaseStats
+{
+	double wallMs = 0; //!< Elapsed time in milliseconds.
+	double cpuMs = 0; //!< CPU time of the thread in milliseconds.
+	unsigned long bytes = 0; //!< Bytes read, or written by the writer.
+	unsigned long lines = 0; //!< Lines read.
+};
+
+//! Statistics of renaming one font.
+struct RenameStats
+{
+	PhaseStats analyze; //!< Loading and analyzing the SFD file.
+	PhaseStats rename; //!< renameGlyphs ().
+	PhaseStats write; //!< writeNewSFD ().
+	unsigned long glyphs = 0; //!< Glyphs in the SFD file.
+	unsigned long ligatures = 0; //!< Ligature2 lines in the SFD file.
+	unsigned long chunks = 0; //!< Parts of the SFD file parsed separately.
+	unsigned long renamed = 0; //!< Glyphs given a new name.
+	unsigned long passes = 0; //!< Passes over the file to rename composites.
+	unsigned long dupChecks = 0; //!< Calls to checkDups ().
+	unsigned long suffixRetries = 0; //!< Taken name_N tried for a new name.
+	unsigned long outBytes = 0; //!< Size of the output SFD file.
+	unsigned long reused = 0; //!< Glyphs whose names came from the name cache.
+	unsigned long dupInput = 0; //!< StartChar names of several input glyphs.
+	unsigned long dupOutput = 0; //!< New names given to glyphs of different names.
+};
+
+//! Measures the wall and CPU time of a phase, from the construction to
+//! stop ().
+class PhaseTimer
+{
+public:
+	PhaseTimer ();
+
+	//! Add the time since the construction to the phase.
+	void stop (PhaseStats& phase);
+private:
+	struct timespec wallStart; //!< Start, CLOCK_MONOTONIC
+	struct timespec cpuStart; //!< Start, CLOCK_THREAD_CPUTIME_ID
+};
+
+//! Write the statistics of the reference file as a table.
+void printRefStatsText (ostream& out, const string& refFile, const PhaseStats& ref);
+
+//! Write the statistics of a font as a table.
+void printStatsText (ostream& out, const string& inFile, int result, const RenameStats& stats);
+
+//! Write the string as a JSON string.
+void printJsonString (ostream& out, const string& str);
+
+//! Write the statistics of the reference file as the start of a JSON object.
+void printRefStatsJson (ostream& out, const string& refFile, const PhaseStats& ref);
+
+//! Write the statistics of a font as a JSON object.
+void printStatsJson (ostream& out, const string& inFile, const string& outFile, int result, const RenameStats& stats, bool first);
+
+//! Close the JSON object started by printRefStatsJson ().
+void printStatsJsonEnd (ostream& out);
+
+#endif
@@ -0,0 +1,269 @@
+#include <iostream>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sfdBuffer.hpp"
+#include "fontClass.hpp"
+#include "jlog.hpp"
+//! \file sfdBuffer.cc
+//! \brief SfdBuffer implementation
+
+SfdBuffer::SfdBuffer ()
+{
+	data = "";
+	size = 0;
+	mapAddr = NULL;
+}
+
+SfdBuffer::~SfdBuffer ()
+{
+	release ();
+}
+
+//! \fn int SfdBuffer::loadFile (const char *fileName)
+//! \brief Load the contents of the file into memory.
+//! Regular files are mapped read only, anything else is read into a
+//! private buffer by readStream ().
+//! \param [in] fileName Name of the file, STDIO_NAME reads stdin.
+//! \returns SUCCESS if the file is loaded.
+//! \returns FAIL if the file cannot be opened or read.
+int SfdBuffer::loadFile (const char *fileName)
+{
+	release ();
+
+	bool useStdin = (strcmp (fileName, STDIO_NAME) == 0);
+	int fd = useStdin ? STDIN_FILENO : open (fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		jERR ("Unable to open " << fileName << " : " << strerror (errno));
+		return FAIL;
+	}
+
+	int retVal = loadFd (fd, fileName);
+	if (!useStdin)
+	{
+		close (fd);
+	}
+	return retVal;
+}
+
+//! \fn int SfdBuffer::loadFd (int fd, const char *fileName)
+//! \brief Load the contents of an open file into memory.
+//! Regular files, memfd included, are mapped from offset 0, anything else
+//! is read from the current position till the end. The file is not
+//! closed.
+//! \param [in] fd The open file.
+//! \param [in] fileName Name of the file, for the messages.
+//! \returns SUCCESS if the file is loaded.
+//! \returns FAIL if the file cannot be read.
+int SfdBuffer::loadFd (int fd, const char *fileName)
+{
+	release ();
+
+	int retVal = FAIL;
+	struct stat st;
+	if (fstat (fd, &st) != 0)
+	{
+		jERR ("Unable to stat " << fileName << " : " << strerror (errno));
+	}
+	else if (S_ISREG (st.st_mode) && (st.st_size > 0)
+		&& (mapFile (fd, st.st_size, fileName) == SUCCESS))
+	{
+		retVal = SUCCESS;
+	}
+	else
+	{
+		//! Not a regular file or mmap failed, read the contents.
+		retVal = readStream (fd, fileName);
+	}
+	return retVal;
+}
+
+//! \fn int SfdBuffer::mapFile (int fd, size_t length, const char *fileName)
+//! \brief Map the file read only.
+//! \param [in] fd The open file.
+//! \param [in] length Size of the file.
+//! \param [in] fileName Name of the file, for the messages.
+//! \returns SUCCESS if the file is mapped.
+//! \returns FAIL if mmap failed.
+int SfdBuffer::mapFile (int fd, size_t length, const char *fileName)
+{
+	void *addr = mmap (NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (addr == MAP_FAILED)
+	{
+		jDBG ("mmap failed for " << fileName << ", reading the file");
+		return FAIL;
+	}
+	madvise (addr, length, MADV_SEQUENTIAL);
+	mapAddr = addr;
+	data = (const char *) addr;
+	size = length;
+	jDBG ("Mapped " << fileName << ", " << size << " bytes");
+	return SUCCESS;
+}
+
+//! \fn static int writeAll (int fd, const char *buf, size_t length)
+//! \brief Write the whole buffer to the file.
+static int writeAll (int fd, const char *buf, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t n = write (fd, buf, length);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return FAIL;
+		}
+		buf += n;
+		length -= n;
+	}
+	return SUCCESS;
+}
+
+//! \fn int SfdBuffer::readStream (int fd, const char *fileName)
+//! \brief Read the file till the end, for pipes and other files that
+//! cannot be mapped.
+//! The data is read into readData. Once it grows beyond SPOOL_SIZE, it is
+//! moved to an anonymous memory file (memfd) and the rest is appended
+//! there, the file is mapped at the end. Large inputs are thus not copied
+//! as the string grows, and are kept out of the heap.
+//! \param [in] fd The open file.
+//! \param [in] fileName Name of the file, for the messages.
+//! \returns SUCCESS if the file is read.
+//! \returns FAIL if the file cannot be read.
+int SfdBuffer::readStream (int fd, const char *fileName)
+{
+	char chunk[65536];
+	ssize_t n;
+	int spoolFd = -1;
+	size_t spoolSize = 0;
+	while ((n = read (fd, chunk, sizeof (chunk))) != 0)
+	{
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			jERR ("Unable to read " << fileName << " : " << strerror (errno));
+			break;
+		}
+
+		if ((spoolFd < 0) && (readData.size () + n > SPOOL_SIZE))
+		{
+			spoolFd = memfd_create ("glyphRen", MFD_CLOEXEC);
+			if (spoolFd < 0)
+			{
+				jDBG ("memfd_create failed : " << strerror (errno)
+					<< ", keeping " << fileName << " on the heap");
+			}
+			else if (writeAll (spoolFd, readData.data (), readData.size ())
+				!= SUCCESS)
+			{
+				n = -1;
+				break;
+			}
+			else
+			{
+				spoolSize = readData.size ();
+				string ().swap (readData);
+			}
+		}
+
+		if (spoolFd < 0)
+		{
+			readData.append (chunk, n);
+		}
+		else if (writeAll (spoolFd, chunk, n) != SUCCESS)
+		{
+			n = -1;
+			break;
+		}
+		else
+		{
+			spoolSize += n;
+		}
+	}
+
+	if ((n < 0) && (spoolFd >= 0))
+	{
+		jERR ("Unable to buffer " << fileName << " : " << strerror (errno));
+	}
+	if ((n == 0) && (spoolFd >= 0)
+		&& (mapFile (spoolFd, spoolSize, fileName) != SUCCESS))
+	{
+		jERR ("Unable to map the buffer of " << fileName << " : "
+			<< strerror (errno));
+		n = -1;
+	}
+	if (spoolFd >= 0)
+	{
+		close (spoolFd);
+	}
+	if (n < 0)
+	{
+		release ();
+		return FAIL;
+	}
+	if (spoolFd >= 0)
+	{
+		return SUCCESS;
+	}
+
+	data = readData.data ();
+	size = readData.size ();
+	jDBG ("Read " << fileName << ", " << size << " bytes");
+	return SUCCESS;
+}
+
+//! Release the mapping or the buffer.
+void SfdBuffer::release (void)
+{
+	if (mapAddr != NULL)
+	{
+		munmap (mapAddr, size);
+		mapAddr = NULL;
+	}
+	readData.clear ();
+	data = "";
+	size = 0;
+}
+
+//! get method for data
+const char *SfdBuffer::getData (void)
+{
+	return data;
+}
+
+//! get method for size
+size_t SfdBuffer::getSize (void)
+{
+	return size;
+}
+
+//! \fn int SfdBuffer::nextLine (size_t& pos, string_view& line)
+//! \brief Get the line starting at pos, without the new line character.
+//! \param [in,out] pos Offset of the line, set to the start of the next
+//! line on return.
+//! \param [out] line The line.
+//! \returns SUCCESS if a line is available.
+//! \returns FAIL at the end of the buffer.
+int SfdBuffer::nextLine (size_t& pos, string_view& line)
+{
+	if (pos >= size)
+	{
+		return FAIL;
+	}
+
+	const char *nl = (const char *) memchr (data + pos, '\n', size - pos);
+	size_t end = (nl != NULL) ? (size_t) (nl - data) : size;
+	line = string_view (data + pos, end - pos);
+	pos = end + 1;
+	return SUCCESS;
+}
@@ -0,0 +1,86 @@
+#ifndef __SFDBUFFER_H
+#define __SFDBUFFER_H
+using namespace std;
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+//! \file sfdBuffer.hpp
+//! \brief Read only, memory mapped view of the input SFD file.
+
+//! File name standing for stdin or stdout.
+#define STDIO_NAME "-"
+
+//! Streams larger than this are buffered in an anonymous memory file.
+#define SPOOL_SIZE (16 * 1024 * 1024)
+
+//! Span holding the glyph name of a StartChar line.
+#define SPAN_STARTCHAR 1
+
+//! Span holding a glyph name of a lookup or class list.
+#define SPAN_NAME 2
+
+//! Span holding the byte count of a class list, which changes with the
+//! length of the names.
+#define SPAN_COUNT 3
+
+//! Location of a glyph name in the SFD buffer.
+//! The spans are recorded in file order while analyzing the SFD file and
+//! used by the writer to splice in the new names.
+struct SfdSpan
+{
+	size_t offset; //!< Byte offset of the span from the start of the buffer
+	size_t length; //!< Length of the span in bytes
+	int type; //!< SPAN_STARTCHAR, SPAN_NAME or SPAN_COUNT
+	union
+	{
+		int nameId; //!< ID of the glyph name, SPAN_STARTCHAR and SPAN_NAME
+		int count; //!< SPAN_NAME spans that follow and are counted, SPAN_COUNT
+	};
+};
+
+//! Holds the contents of the SFD file.
+//! Regular files are mapped into memory, other files (pipes, stdin etc.)
+//! are read into a private buffer, or an anonymous memory file if they
+//! are large. The data is read once and shared by the analyzer and the
+//! writer.
+class SfdBuffer
+{
+public:
+	SfdBuffer ();
+	~SfdBuffer ();
+	SfdBuffer (const SfdBuffer&) = delete;
+	SfdBuffer& operator= (const SfdBuffer&) = delete;
+
+	//! Map or read the file into memory.
+	int loadFile (const char *fileName);
+
+	//! Map or read an open file into memory.
+	int loadFd (int fd, const char *fileName);
+
+	//! Release the memory held by the buffer.
+	void release (void);
+
+	//! get method for data
+	const char *getData (void);
+
+	//! get method for size
+	size_t getSize (void);
+
+	//! Get the line starting at pos and move pos to the next line.
+	int nextLine (size_t& pos, string_view& line);
+
+private:
+	//! Map a regular file.
+	int mapFile (int fd, size_t length, const char *fileName);
+
+	//! Read a file that cannot be mapped.
+	int readStream (int fd, const char *fileName);
+
+	const char *data; //!< Start of the file contents
+	size_t size; //!< Size of the file contents
+	void *mapAddr; //!< Address returned by mmap, NULL if not mapped.
+	string readData; //!< File contents if the file could not be mapped.
+};
+
+#endif
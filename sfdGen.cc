@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <random>
+#include <algorithm>
+#include <vector>
+#include "sfdGen.hpp"
+#include "fontClass.hpp"
+//! \file sfdGen.cc
+//! \brief Generator of synthetic SFD files and reference files.
+
+//! First code point of the generated base glyphs.
+#define GEN_FIRST_CODEPT 0x10000
+
+//! \fn int generateFont (const GenParams& params, string& sfd, string& ref)
+//! \brief Generate a SFD file and the matching reference file.
+//!
+//! A quarter of the glyphs (at least two) are encoded base glyphs, listed
+//! in the reference file. The rest are composite glyphs spread over
+//! chainDepth levels, the first component of a composite is taken from
+//! the level below it and the others are base glyphs, so the renames
+//! have to go level by level. The composites are shuffled in the file so
+//! that many of them appear before their components.
+//!
+//! A collideFrac fraction of the composites copy the ligatures of an
+//! earlier composite of the same level. They get the same new name and
+//! have to be given a sequence number.
+//! \param [in] params Shape of the font.
+//! \param [out] sfd Contents of the SFD file.
+//! \param [out] ref Contents of the reference file.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the parameters are not valid.
+int generateFont (const GenParams& params, string& sfd, string& ref)
+{
+	if ((params.glyphCount < 3) || (params.ligsPerGlyph == 0)
+		|| (params.chainDepth == 0))
+	{
+		return FAIL;
+	}
+
+	mt19937 rng (params.seed);
+	unsigned int baseCount = params.glyphCount / 4;
+	if (baseCount < 2)
+	{
+		baseCount = 2;
+	}
+	unsigned int compCount = params.glyphCount - baseCount;
+
+	//! Ligatures of the composite glyphs, as glyph name lists.
+	vector<vector<string> > compLigs (compCount);
+	//! Composites of each level, level 0 being the base glyphs.
+	vector<vector<unsigned int> > levels (params.chainDepth + 1);
+	char buf[64];
+
+	ref.clear ();
+	for (unsigned int i = 0; i < baseCount; i++)
+	{
+		snprintf (buf, sizeof (buf), "%04X b%u\n", GEN_FIRST_CODEPT + i, i);
+		ref.append (buf);
+		levels[0].push_back (i);
+	}
+
+	uniform_real_distribution<double> frac (0.0, 1.0);
+	for (unsigned int c = 0; c < compCount; c++)
+	{
+		unsigned int level = 1 + c % params.chainDepth;
+		vector<unsigned int>& below = levels[level - 1];
+		vector<unsigned int>& same = levels[level];
+
+		if (!same.empty () && (frac (rng) < params.collideFrac))
+		{
+			compLigs[c] = compLigs[same[rng () % same.size ()] - baseCount];
+		}
+		else
+		{
+			for (unsigned int l = 0; l < params.ligsPerGlyph; l++)
+			{
+				string lig;
+				unsigned int first = below.empty () ? 0
+					: below[rng () % below.size ()];
+				snprintf (buf, sizeof (buf), "g%u", first);
+				lig = buf;
+				unsigned int extra = 1 + rng () % 2;
+				for (unsigned int k = 0; k < extra; k++)
+				{
+					snprintf (buf, sizeof (buf), " g%u", (unsigned int) (rng () % baseCount));
+					lig.append (buf);
+				}
+				compLigs[c].push_back (lig);
+			}
+		}
+		same.push_back (baseCount + c);
+	}
+
+	//! File order of the composites.
+	vector<unsigned int> order (compCount);
+	for (unsigned int c = 0; c < compCount; c++)
+	{
+		order[c] = c;
+	}
+	shuffle (order.begin (), order.end (), rng);
+
+	static const char *forms[] = {"akhn", "blwf", "pstf", "half", "pres"};
+
+	sfd.clear ();
+	sfd.reserve ((size_t) params.glyphCount * 160);
+	snprintf (buf, sizeof (buf), "BeginChars: %u %u\n\n",
+		GEN_FIRST_CODEPT + params.glyphCount, params.glyphCount);
+	sfd.append ("SplineFontDB: 3.0\nFontName: Synthetic\nEncoding: UnicodeFull\n");
+	sfd.append (buf);
+
+	for (unsigned int gid = 0; gid < params.glyphCount; gid++)
+	{
+		unsigned int g = (gid < baseCount) ? gid
+			: baseCount + order[gid - baseCount];
+		int codePt = (g < baseCount) ? (int) (GEN_FIRST_CODEPT + g) : -1;
+
+		snprintf (buf, sizeof (buf), "StartChar: g%u\n", g);
+		sfd.append (buf);
+		snprintf (buf, sizeof (buf), "Encoding: %d %d %u\n",
+			(codePt >= 0) ? codePt : (int) (GEN_FIRST_CODEPT + params.glyphCount + gid),
+			codePt, gid);
+		sfd.append (buf);
+		sfd.append ("Width: 1000\nFlags: W\nLayerCount: 2\nFore\nSplineSet\n"
+			"100 200 m 1\n 300 400 l 1\nEndSplineSet\n");
+		if (g >= baseCount)
+		{
+			vector<string>& ligs = compLigs[g - baseCount];
+			for (unsigned int l = 0; l < ligs.size (); l++)
+			{
+				const char *form = forms[(g + l) % 5];
+				sfd.append ("Ligature2: \"'");
+				sfd.append (form);
+				sfd.append ("' Lookup ");
+				sfd.append (form);
+				sfd.append (" subtable\" ");
+				sfd.append (ligs[l]);
+				sfd.append ("\n");
+			}
+		}
+		sfd.append ("EndChar\n\n");
+	}
+	sfd.append ("EndChars\nEndSplineFont\n");
+	return SUCCESS;
+}
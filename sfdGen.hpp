@@ -0,0 +1,21 @@
+#ifndef __SFDGEN_H
+#define __SFDGEN_H
+using namespace std;
+#include <string>
+//! \file sfdGen.hpp
+//! \brief Generator of synthetic SFD files and reference files.
+
+//! Shape of the generated font.
+struct GenParams
+{
+	unsigned int glyphCount = 1000; //!< Total number of glyphs.
+	unsigned int ligsPerGlyph = 1; //!< Ligature2 lines per composite glyph.
+	unsigned int chainDepth = 2; //!< Levels of composites built on composites.
+	double collideFrac = 0.1; //!< Fraction of composites whose new name collides.
+	unsigned int seed = 1; //!< Seed of the random number generator.
+};
+
+//! Generate a SFD file and the matching reference file.
+int generateFont (const GenParams& params, string& sfd, string& ref);
+
+#endif
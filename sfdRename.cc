@@ -0,0 +1,2300 @@
+using namespace std;
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <queue>
+#include <deque>
+#include <unordered_set>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include "sfdRename.hpp"
+#include "memReport.hpp"
+#include "threadPool.hpp"
+#include "jlog.hpp"
+
+//! \file sfdRename.cc
+//! \brief Rename the glyphs of a SFD file.
+//!
+//!	1. Read the code points and the standard values from the Reference file.
+//!	2. Read all Unicode characters and the names into the list	
+//!	3. Traverse through the list of characters and set the new names
+//!		for the characters.
+//!	4. Write the new SFD file with renamed glyphs
+//!
+//! The SFD file is loaded into memory once (mapped, if possible). While
+//! analyzing, the location of every glyph name is recorded, the writer
+//! copies the data between these locations as it is and splices in the
+//! new names.
+//!
+//! The names resolved by a run can be exported as a RenameMap and applied
+//! to other SFD and text files by applyRenameMap (), without the
+//! reference file.
+
+//! \fn int renameFont (const RefTable& vRefData, const string& inFile, const string& outFile, const RenameOptions& options, RenameStats& stats)
+//! \brief Rename the glyphs of one SFD file.
+//! All the data other than the reference data is private to the call,
+//! fonts can be renamed in parallel.
+//! \param [in] vRefData Reference data.
+//! \param [in] inFile Name of the input SFD file, STDIO_NAME for stdin.
+//! \param [in] outFile Name of the output SFD file, STDIO_NAME for stdout.
+//! \param [in] options Options for the font.
+//! \param [out] stats Time and counters of the phases.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if operation is not successful.
+int renameFont (const RefTable& vRefData, const string& inFile,
+	const string& outFile, const RenameOptions& options, RenameStats& stats)
+{
+	//! Glyph data from the SFD file, an array per field.
+	GlyphStore glyphs;
+
+	//! Symbol table of the glyph names, the glyphs and their ligatures
+	//! refer to the names by their ID.
+	NameTable names;
+
+	int retVal;
+
+	//! Load the input SFD file, it is shared by the analyzer and the writer.
+	PhaseTimer analyzeTimer;
+	MemPhase memPhase (MEM_PARSE);
+	SfdBuffer sfdBuf;
+	retVal = (options.inFd >= 0) ? sfdBuf.loadFd (options.inFd, inFile.c_str ())
+		: sfdBuf.loadFile (inFile.c_str ());
+	if (SUCCESS != retVal)
+	{
+		jERR ("Error : Unable to load SFD file " << inFile);
+		return FAIL;
+	}
+
+	//! Location of the glyph names in the SFD file.
+	vector<SfdSpan> vSpan;
+
+	//! Analyze the input SFD file and load the data into the GlyphStore.
+	retVal = analyzeSFDFile (sfdBuf, names, glyphs, vSpan, stats,
+		options.fontThreads);
+	analyzeTimer.stop (stats.analyze);
+	if (SUCCESS != retVal)
+	{
+		jERR ("Error : analyzeSFDFile failed for " << inFile);
+		return FAIL;
+	}
+	if (options.strict && (stats.dupInput > 0))
+	{
+		jERR ("Error : " << stats.dupInput << " duplicate glyph name(s) in "
+			<< inFile);
+		return FAIL;
+	}
+
+	//! The rename map, indexed by the ID of the old name. It contains the
+	//! ID of the new name, NO_NAME if the glyph is not renamed.
+	PhaseTimer renameTimer;
+	memPhase.set (MEM_RENAME);
+	vector<int> nameMap (names.getCount (), NO_NAME);
+	int renCount = 0;
+
+	//! With the name cache, only the glyphs changed since the previous run
+	//! are renamed. If the names cannot be reused, all the glyphs are.
+	string cacheFile = outFile + NAME_CACHE_EXT;
+	NameCache cache;
+	retVal = FAIL;
+	if (options.useCache
+		&& (cache.load (cacheFile.c_str (), vRefData.getSrcHash ()) == SUCCESS))
+	{
+		retVal = reuseNames (vRefData, names, glyphs, cache, nameMap,
+			renCount, stats);
+		if (SUCCESS != retVal)
+		{
+			jLOG ("Renaming all the glyphs of " << inFile);
+			nameMap.assign (nameMap.size (), NO_NAME);
+			glyphs.resetNames ();
+		}
+	}
+
+	//! Traverse the glyph info and rename the glyphs
+	if (SUCCESS != retVal)
+	{
+		retVal = renameGlyphs (vRefData, names, glyphs, nameMap, renCount,
+			stats);
+	}
+	renameTimer.stop (stats.rename);
+	if (SUCCESS != retVal)
+	{
+		jERR ("Error : renameGlyphs failed for " << inFile);
+		return FAIL;
+	}
+	jLOG ("Number of glyphs renamed : " << renCount);
+	stats.dupOutput = findNewDups (names, glyphs, nameMap);
+	if (options.strict && (stats.dupOutput > 0))
+	{
+		jERR ("Error : " << stats.dupOutput << " duplicate glyph name(s) in "
+			<< "the output of " << inFile);
+		return FAIL;
+	}
+	
+	jDBG ("Starting writeNewSFD ========================================");
+	//! Write a new file with new glyph names.
+	PhaseTimer writeTimer;
+	memPhase.set (MEM_WRITE);
+	retVal = writeNewSFD (sfdBuf, vSpan, outFile.c_str (), options.outFd,
+		names, nameMap, stats);
+	writeTimer.stop (stats.write);
+	if (SUCCESS != retVal)
+	{
+		jERR ("Error : writeNewSFD failed for " << outFile);
+		return FAIL;
+	}
+	showMap (names, nameMap);
+
+	if (options.useCache)
+	{
+		cache.save (cacheFile.c_str (), vRefData.getSrcHash (), names,
+			glyphs, nameMap);
+	}
+
+	if (!options.exportMap.empty ())
+	{
+		RenameMap renameMap;
+		if (renameMap.save (options.exportMap.c_str (), names, nameMap)
+			!= SUCCESS)
+		{
+			jERR ("Error : Unable to export the rename map of " << inFile);
+			return FAIL;
+		}
+	}
+	return SUCCESS;
+}
+
+//! \fn int applyRenameMap (const RenameMap& renameMap, const string& inFile, const string& outFile, const RenameOptions& options, RenameStats& stats)
+//! \brief Rename the glyph names of a file using an exported rename map.
+//! The reference data is not needed and no names are resolved, the names
+//! in the map are replaced as they are. A SFD file is analyzed to find
+//! the glyph names and written like renameFont () does, so the byte
+//! counts of the class lists stay correct. Any other file is renamed word
+//! by word by rewriteText ().
+//! \param [in] renameMap The glyphs to rename.
+//! \param [in] inFile Name of the input file, STDIO_NAME for stdin.
+//! \param [in] outFile Name of the output file, STDIO_NAME for stdout.
+//! \param [in] options Options for the font.
+//! \param [out] stats Time and counters of the phases.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if operation is not successful.
+int applyRenameMap (const RenameMap& renameMap, const string& inFile,
+	const string& outFile, const RenameOptions& options, RenameStats& stats)
+{
+	int retVal;
+	int renCount = 0;
+
+	PhaseTimer analyzeTimer;
+	MemPhase memPhase (MEM_PARSE);
+	SfdBuffer sfdBuf;
+	retVal = (options.inFd >= 0) ? sfdBuf.loadFd (options.inFd, inFile.c_str ())
+		: sfdBuf.loadFile (inFile.c_str ());
+	if (SUCCESS != retVal)
+	{
+		jERR ("Error : Unable to load " << inFile);
+		return FAIL;
+	}
+
+	string_view head (sfdBuf.getData (), sfdBuf.getSize ());
+	if (head.substr (0, strlen (SFD_MAGIC_TEXT)) != SFD_MAGIC_TEXT)
+	{
+		analyzeTimer.stop (stats.analyze);
+		stats.analyze.bytes = sfdBuf.getSize ();
+		PhaseTimer writeTimer;
+		memPhase.set (MEM_WRITE);
+		retVal = rewriteText (sfdBuf, renameMap, outFile.c_str (),
+			options.outFd, renCount, stats);
+		writeTimer.stop (stats.write);
+		if (SUCCESS != retVal)
+		{
+			jERR ("Error : rewriteText failed for " << outFile);
+			return FAIL;
+		}
+		stats.renamed = renCount;
+		jLOG ("Number of names renamed : " << renCount);
+		return SUCCESS;
+	}
+
+	NameTable names;
+	GlyphStore glyphs;
+	vector<SfdSpan> vSpan;
+	retVal = analyzeSFDFile (sfdBuf, names, glyphs, vSpan, stats,
+		options.fontThreads);
+	analyzeTimer.stop (stats.analyze);
+	if (SUCCESS != retVal)
+	{
+		jERR ("Error : analyzeSFDFile failed for " << inFile);
+		return FAIL;
+	}
+	if (options.strict && (stats.dupInput > 0))
+	{
+		jERR ("Error : " << stats.dupInput << " duplicate glyph name(s) in "
+			<< inFile);
+		return FAIL;
+	}
+
+	PhaseTimer renameTimer;
+	memPhase.set (MEM_RENAME);
+	vector<int> nameMap;
+	renameMap.buildMap (names, nameMap, renCount);
+	renameTimer.stop (stats.rename);
+	stats.renamed = renCount;
+	jLOG ("Number of glyphs renamed : " << renCount);
+	stats.dupOutput = findNewDups (names, glyphs, nameMap);
+	if (options.strict && (stats.dupOutput > 0))
+	{
+		jERR ("Error : " << stats.dupOutput << " duplicate glyph name(s) in "
+			<< "the output of " << inFile);
+		return FAIL;
+	}
+
+	PhaseTimer writeTimer;
+	memPhase.set (MEM_WRITE);
+	retVal = writeNewSFD (sfdBuf, vSpan, outFile.c_str (), options.outFd,
+		names, nameMap, stats);
+	writeTimer.stop (stats.write);
+	if (SUCCESS != retVal)
+	{
+		jERR ("Error : writeNewSFD failed for " << outFile);
+		return FAIL;
+	}
+	return SUCCESS;
+}
+
+//! \fn int loadReferenceData (const char *refFile, RefTable& ref)
+//! \brief Load the reference data from the reference file
+//! The binary cache written by --compile-ref is used if it matches the
+//! contents of the reference file, otherwise the file is parsed.
+//! \param [in] refFile Name of the file containing reference data.
+//! \param [out] ref The RefTable that will hold the ref data.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if operation is not successful.
+int loadReferenceData (const char *refFile, RefTable& ref)
+{
+	jLOG ("Loading Reference data");
+
+	string cacheFile = string (refFile) + REF_CACHE_EXT;
+	if (ref.loadCache (cacheFile.c_str (), refFile) == SUCCESS)
+	{
+		jLOG ("Finished Loading Reference data from " << cacheFile);
+		return (SUCCESS);
+	}
+
+	//! Read the data from the reference file
+	if (ref.loadText (refFile) != SUCCESS)
+	{
+		return (FAIL);
+	}
+	jLOG ("Finished Loading Reference data");
+	return (SUCCESS);
+}
+
+//! \fn int analyzeSFDFile (SfdBuffer& sfdBuf, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats, unsigned int threads)
+//! \brief Analyze the input SFD file and load the data into the GlyphStore.
+//! \param [in] sfdBuf Contents of the input SFD file.
+//! \param [out] names Symbol table to which the glyph names are added.
+//! \param [out] glyphs Store holding the glyph data.
+//! \param [out] vSpan Location of the glyph names in sfdBuf, in file order.
+//! \param [out] stats Lines and bytes read, glyphs and ligatures found.
+//! \param [in] threads Number of threads parsing the file.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if operation is not successful.
+//
+//! Files of at least two chunks of MIN_CHUNK_SIZE are split at StartChar
+//! lines and the chunks are parsed in parallel by analyzeChunk (). The
+//! glyphs of the chunks are then merged in file order, the names are
+//! added to the symbol table in the order they appear in the file so the
+//! IDs are the same as those of a serial parse.
+//!
+//! A chunk does not know the state the previous chunk ended in. If the
+//! first glyph of a chunk has no Encoding line, it takes the code point of
+//! the glyph before it, and if there are Ligature2 lines after the last
+//! EndChar of a chunk, they belong to the next glyph. In these cases the
+//! file is parsed again on the calling thread.
+//!
+//! The StartChar names used by more than one glyph are reported and
+//! counted in stats.dupInput.
+int analyzeSFDFile (SfdBuffer& sfdBuf, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats, unsigned int threads)
+{
+	bool carryIn;
+	bool carryOut;
+	int retVal;
+
+	jLOG ("Analyzing the SFD file");
+	unsigned int count = sfdBuf.getSize () / MIN_CHUNK_SIZE;
+	if (count > threads * 4)
+	{
+		count = threads * 4;
+	}
+
+	vector<size_t> bounds;
+	if ((threads > 1) && (count > 1)
+		&& (splitChunks (sfdBuf, count, bounds) == SUCCESS))
+	{
+		vector<unique_ptr<SfdChunk> > chunks;
+		for (unsigned int i = 0; i + 1 < bounds.size (); i++)
+		{
+			chunks.push_back (make_unique<SfdChunk> ());
+			chunks[i]->begin = bounds[i];
+			chunks[i]->end = bounds[i + 1];
+		}
+		if (threads > chunks.size ())
+		{
+			threads = chunks.size ();
+		}
+		jLOG ("Parsing " << chunks.size () << " chunk(s) on "
+			<< threads << " thread(s)");
+
+		{
+			ThreadPool pool (threads);
+			for (unsigned int i = 0; i < chunks.size (); i++)
+			{
+				SfdChunk *chunk = chunks[i].get ();
+				pool.submit ([&sfdBuf, chunk] ()
+					{
+						MemPhase memPhase (MEM_PARSE);
+						PhaseTimer chunkTimer;
+						chunk->result = analyzeChunk (sfdBuf, chunk->begin,
+							chunk->end, chunk->names, chunk->glyphs,
+							chunk->vSpan, chunk->stats,
+							chunk->carryIn, chunk->carryOut);
+						chunkTimer.stop (chunk->stats.analyze);
+					});
+			}
+			pool.wait ();
+		}
+
+		retVal = mergeChunks (chunks, names, glyphs, vSpan, stats);
+		if (retVal == SUCCESS)
+		{
+			stats.analyze.bytes += sfdBuf.getSize ();
+			stats.dupInput += findDupGlyphs (names, glyphs);
+			jLOG ("Finished analyzing the SFD file");
+			return SUCCESS;
+		}
+		jLOG ("Chunks depend on each other, parsing the SFD file serially");
+	}
+
+	retVal = analyzeChunk (sfdBuf, 0, sfdBuf.getSize (), names, glyphs,
+		vSpan, stats, carryIn, carryOut);
+	if (retVal != SUCCESS)
+	{
+		return FAIL;
+	}
+	stats.analyze.bytes += sfdBuf.getSize ();
+	stats.chunks++;
+	stats.dupInput += findDupGlyphs (names, glyphs);
+	jLOG ("Finished analyzing the SFD file");
+	return SUCCESS;
+}
+
+//! \fn unsigned long findDupGlyphs (NameTable& names, GlyphStore& glyphs)
+//! \brief Find the StartChar names used by more than one glyph. The
+//! names were added to the symbol table as the file was scanned, so the
+//! glyphs are counted per name ID without reading the file again.
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] glyphs The glyphs of the file.
+//! \returns The number of names used by more than one glyph. The first
+//! DUP_MAX_REPORTS are reported.
+unsigned long findDupGlyphs (NameTable& names, GlyphStore& glyphs)
+{
+	vector<unsigned int> useCount (names.getCount (), 0);
+	unsigned long dupCount = 0;
+
+	for (unsigned int i = 0; i < glyphs.getCount (); i++)
+	{
+		useCount[glyphs.getCurId (i)]++;
+	}
+	for (unsigned int i = 0; i < glyphs.getCount (); i++)
+	{
+		int name = glyphs.getCurId (i);
+		if (useCount[name] > 1)
+		{
+			if (dupCount < DUP_MAX_REPORTS)
+			{
+				jWARN ("Glyph name [" << names.getName (name) << "] is used by "
+					<< useCount[name] << " glyphs");
+			}
+			dupCount++;
+			useCount[name] = 0;
+		}
+	}
+	return dupCount;
+}
+
+//! \fn unsigned long findNewDups (NameTable& names, GlyphStore& glyphs, vector<int>& nameMap)
+//! \brief Find the new names given to glyphs that have different names in
+//! the input. Glyphs of the same input name keep sharing it and are
+//! counted by findDupGlyphs ().
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] glyphs The glyphs of the file.
+//! \param [in] nameMap The rename map, indexed by the old name ID.
+//! \returns The number of new names given to glyphs of different names.
+//! The first DUP_MAX_REPORTS are reported.
+unsigned long findNewDups (NameTable& names, GlyphStore& glyphs, vector<int>& nameMap)
+{
+	//! Old name of the first glyph given each name, indexed by name ID.
+	vector<int> owner (names.getCount (), NO_ID);
+	vector<bool> reported (names.getCount (), false);
+	unsigned long dupCount = 0;
+
+	for (unsigned int i = 0; i < glyphs.getCount (); i++)
+	{
+		int oldName = glyphs.getCurId (i);
+		int newName = (nameMap[oldName] != NO_NAME) ? nameMap[oldName] : oldName;
+		if (owner[newName] == NO_ID)
+		{
+			owner[newName] = oldName;
+		}
+		else if ((owner[newName] != oldName) && !reported[newName])
+		{
+			if (dupCount < DUP_MAX_REPORTS)
+			{
+				jWARN ("Glyphs [" << names.getName (owner[newName]) << "] and ["
+					<< names.getName (oldName) << "] are both named ["
+					<< names.getName (newName) << "]");
+			}
+			dupCount++;
+			reported[newName] = true;
+		}
+	}
+	return dupCount;
+}
+
+//! \fn int splitChunks (SfdBuffer& sfdBuf, unsigned int count, vector<size_t>& bounds)
+//! \brief Split the SFD file into about count chunks of the same size.
+//! Each boundary is moved forward to the next line starting with
+//! StartChar.
+//! \param [in] sfdBuf Contents of the input SFD file.
+//! \param [in] count Number of chunks wanted.
+//! \param [out] bounds Offsets of the chunks, followed by the size of
+//! the file.
+//! \returns SUCCESS if there are at least two chunks.
+//! \returns FAIL if the file cannot be split.
+int splitChunks (SfdBuffer& sfdBuf, unsigned int count, vector<size_t>& bounds)
+{
+	string_view data (sfdBuf.getData (), sfdBuf.getSize ());
+	string startLine = string ("\n") + START_CHAR_TEXT;
+
+	bounds.clear ();
+	bounds.push_back (0);
+	for (unsigned int i = 1; i < count; i++)
+	{
+		size_t target = (data.size () / count) * i;
+		if (target <= bounds.back ())
+		{
+			target = bounds.back () + 1;
+		}
+		size_t found = data.find (startLine, target - 1);
+		if (found == string_view::npos)
+		{
+			break;
+		}
+		bounds.push_back (found + 1);
+	}
+	bounds.push_back (data.size ());
+
+	return (bounds.size () > 2) ? SUCCESS : FAIL;
+}
+
+//! \fn int mergeChunks (vector<unique_ptr<SfdChunk> >& chunks, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats)
+//! \brief Move the glyphs and spans of the chunks to the font, in file
+//! order, changing the name IDs of the chunks to those of names.
+//! \param [in] chunks The parsed chunks.
+//! \param [out] names Symbol table to which the glyph names are added.
+//! \param [out] glyphs Store holding the glyph data.
+//! \param [out] vSpan Location of the glyph names in sfdBuf, in file order.
+//! \param [out] stats Lines read, glyphs and ligatures found.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if a chunk could not be parsed or the result may differ
+//! from a serial parse. Nothing is added to the output in that case.
+int mergeChunks (vector<unique_ptr<SfdChunk> >& chunks, NameTable& names,
+	GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats)
+{
+	unsigned int i;
+	size_t glyphCount = 0;
+	size_t ligCount = 0;
+	size_t compCount = 0;
+	size_t spanCount = 0;
+
+	for (i = 0; i < chunks.size (); i++)
+	{
+		SfdChunk& chunk = *chunks[i];
+		if ((chunk.result != SUCCESS) || ((i > 0) && chunk.carryIn)
+			|| ((i + 1 < chunks.size ()) && chunk.carryOut))
+		{
+			jDBG ("Chunk " << i << " at " << chunk.begin << " result "
+				<< chunk.result << " carryIn " << chunk.carryIn
+				<< " carryOut " << chunk.carryOut);
+			return FAIL;
+		}
+		unsigned int chunkGlyphs = chunk.glyphs.getCount ();
+		glyphCount += chunkGlyphs;
+		ligCount += chunk.glyphs.getLigBegin (chunkGlyphs);
+		compCount += chunk.glyphs.getCompBegin (
+			chunk.glyphs.getLigBegin (chunkGlyphs));
+		spanCount += chunk.vSpan.size ();
+	}
+
+	glyphs.reserve (glyphCount, ligCount, compCount);
+	vSpan.reserve (vSpan.size () + spanCount);
+	for (i = 0; i < chunks.size (); i++)
+	{
+		SfdChunk& chunk = *chunks[i];
+
+		//! The names are added in the order of the first use in the file.
+		vector<int> idMap (chunk.names.getCount (), NO_NAME);
+		for (unsigned int id = 0; id < idMap.size (); id++)
+		{
+			idMap[id] = names.intern (chunk.names.getName (id));
+		}
+
+		glyphs.append (chunk.glyphs, idMap);
+		for (unsigned int n = 0; n < chunk.vSpan.size (); n++)
+		{
+			SfdSpan span = chunk.vSpan[n];
+			if (span.type != SPAN_COUNT)
+			{
+				span.nameId = idMap[span.nameId];
+			}
+			vSpan.push_back (span);
+		}
+
+		stats.analyze.lines += chunk.stats.analyze.lines;
+		stats.analyze.cpuMs += chunk.stats.analyze.cpuMs;
+		stats.glyphs += chunk.stats.glyphs;
+		stats.ligatures += chunk.stats.ligatures;
+		chunk.vSpan.clear ();
+	}
+	stats.chunks += chunks.size ();
+	return SUCCESS;
+}
+
+//! \fn int analyzeChunk (SfdBuffer& sfdBuf, size_t begin, size_t end, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats, bool& carryIn, bool& carryOut)
+//! \brief Analyze the lines of the SFD file between begin and end and load
+//! the data into the GlyphStore.
+//! \param [in] sfdBuf Contents of the input SFD file.
+//! \param [in] begin Offset of the first line.
+//! \param [in] end Offset of the line after the last one.
+//! \param [out] names Symbol table to which the glyph names are added.
+//! \param [out] glyphs Store holding the glyph data.
+//! \param [out] vSpan Location of the glyph names in sfdBuf, in file order.
+//! \param [out] stats Lines read, glyphs and ligatures found.
+//! \param [out] carryIn Set if the first glyph has no Encoding line, it
+//! takes the code point of the glyph before the chunk.
+//! \param [out] carryOut Set if Ligature2 or StartChar lines follow the
+//! last EndChar, they belong to the glyph after the chunk, or the chunk
+//! ends within a list of classes.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if operation is not successful.
+//
+//! The glyphs are enclosed within [StartChar:] and [EndChar] sections. 
+//! Read the SFD file and load the following into the GlyphStore:
+//! -# Name of the glyph as mentioned in the SFD file.
+//! -# Start position(?) of the glyph
+//! -# End position(?) of the glyph
+//! -# Code point value of the glyph
+//! -# Skip the glyph if it is not a Malayalam glyph
+//!
+//! The offsets of the glyph names in the StartChar and Ligature2 lines,
+//! and in the other lines listed by indexGlyphLists (), are saved to vSpan
+//! for writeNewSFD.
+//
+int analyzeChunk (SfdBuffer& sfdBuf, size_t begin, size_t end, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats, bool& carryIn, bool& carryOut)
+{
+	string_view glyphName; // Name of the glyph from SFD file
+	int glyphId = NO_NAME; // ID of glyphName
+	int dataFlag; // Indicate if the StartChar pattern is found
+	int startPos = 0;
+	int codeValue = 0;
+	bool encodingFound = false; // Encoding line seen in the chunk
+	size_t glyphCount = glyphs.getCount ();
+	string_view sfdData; // Line from the SFD buffer
+	size_t linePos; // Offset of the line in the SFD buffer
+	size_t nextPos; // Offset of the next line in the SFD buffer
+	int retVal;
+	SfdTokenizer tok;
+	uint64_t print = NAME_HASH_SEED; // Fingerprint of the glyph
+
+	GlyphListState listState;
+	carryIn = false;
+	carryOut = false;
+
+	//! Read the data from the input SFD file.
+	dataFlag = 0;
+	int lineNo = 0;
+	nextPos = begin;
+	while (nextPos < end)
+	{
+		linePos = nextPos;
+		if (sfdBuf.nextLine (nextPos, sfdData) != SUCCESS)
+		{
+			break;
+		}
+		lineNo++;
+		//! Look for [StartChar:]
+		size_t found;
+		found = sfdData.find (START_CHAR_TEXT);
+		if (found != string::npos)
+		{
+			 jTRACE ("Rec# " << lineNo <<  " Processing ["
+			 		<< sfdData << "]");
+			dataFlag = 1;
+			//! [StartChar:] found, extract the glyph name which is
+			//! the 2nd token.
+			tok.split (sfdData, ' ');
+			if (tok.getTok (2, glyphName) != SUCCESS)
+			{
+				return FAIL;
+			}
+			glyphId = names.intern (glyphName);
+			print = NameCache::hashLine (print, sfdData);
+
+			SfdSpan span;
+			span.offset = linePos + tok.getOffset (2);
+			span.length = glyphName.length ();
+			span.type = SPAN_STARTCHAR;
+			span.nameId = glyphId;
+			vSpan.push_back (span);
+		}
+
+		//! Look for [Encoding:] 
+		found = sfdData.find (ENCODING_TEXT);
+		if (found != string::npos)
+		{
+			jTRACE (setw(5) << "Rec# " <<lineNo <<  " Processing ["
+					<< sfdData << "]");
+			//! Check if StartChar is already found, if not skip.
+			if (0 == dataFlag)
+			{
+				jTRACE (setw (5) << "Rec# " << lineNo <<  " Skipping [" 
+					<< sfdData << "]");
+				continue;
+			}
+			print = NameCache::hashLine (print, sfdData);
+			encodingFound = true;
+			//! [Encoding:] found, extract start, code point value, and end.
+			string_view tmpStr; 
+			tok.split (sfdData, ' ');
+			 if (tok.getTok (2, tmpStr) != SUCCESS)
+			 {
+			 	return FAIL;
+			 }
+			 else
+			 {
+			 	parseInt (tmpStr, startPos);
+			 }
+
+			 // Code point value at position 3
+			 if (tok.getTok (3, tmpStr) != SUCCESS)
+			 {
+			 	return FAIL;
+			 }
+			 else
+			 {
+				parseInt (tmpStr, codeValue);
+			 }
+		}
+		
+		//! Look for Ligature
+		found = sfdData.find (LIGATURE_TEXT);
+		if (found != string::npos)
+		{
+			 jTRACE ("Rec# " << lineNo <<  " Processing ["
+				<< sfdData << "]");
+			print = NameCache::hashLine (print, sfdData);
+
+			//! The glyph list is the 3rd token when the delimiter is double
+			//! quotes.
+			string_view tmpStr;
+			tok.split (sfdData, '"');
+			if (tok.getTok (3, tmpStr) == SUCCESS)
+			{
+				addNameSpans (tmpStr, linePos + tok.getOffset (3), names,
+					vSpan);
+			}
+
+			//! Split the data and add it to the ligatures of the glyph.
+			retVal = storeLigature (sfdData, names, glyphs, tok);
+			if (retVal != SUCCESS)
+			{
+				jERR ("Error : storeLigature [" << sfdData << "]");
+				continue;
+			}
+			jTRACE ("Rec# " << lineNo <<  " Storing Ligatures");
+			stats.ligatures++;
+		}
+
+		//! The other lists of glyph names, only their location is saved.
+		indexGlyphLists (sfdData, linePos, names, vSpan, tok, listState);
+
+		//! Look for EndChar, the EndChars line closing the glyphs does not
+		//! end a glyph.
+		found = sfdData.find (END_CHAR_TEXT);
+		if ((found != string::npos)
+			&& (sfdData.find_first_not_of (" \t\r",
+				found + strlen (END_CHAR_TEXT)) == string_view::npos))
+		{
+			jTRACE (setw(5) << "Rec# " << lineNo <<  " Processing ["
+				<< sfdData << "]");
+			
+			if (!encodingFound)
+			{
+				carryIn = true;
+			}
+
+			//! Save the glyph name, start pos and code value, the glyph
+			//! takes the ligatures stored since the previous glyph. The new
+			//! name depends only on the lines hashed so far.
+			unsigned int glyph = glyphs.addGlyph (glyphId, startPos,
+				codeValue, print);
+			print = NAME_HASH_SEED;
+			glyphs.displayData (glyph, names);
+			jTRACE (setw(5) << "Rec# " << lineNo << " Added glyph info for " <<
+				glyphName << "]");
+		}
+	}
+	if ((glyphs.getOpenLigatures () > 0) || (print != NAME_HASH_SEED)
+		|| (listState.classLines > 0) || listState.inFpst)
+	{
+		carryOut = true;
+	}
+	stats.analyze.lines += lineNo;
+	stats.glyphs += glyphs.getCount () - glyphCount;
+	return SUCCESS;
+}
+
+//! Contextual lookups, the glyph lists follow till EndFPST.
+static const char *FpstText[] = {"ContextPos2:", "ContextSub2:", "ChainPos2:",
+	"ChainSub2:", "ReverseChain2:"};
+
+//! Glyph lists of the contextual lookups, a byte count and the names.
+static const char *FpstListText[] = {"Class:", "BClass:", "FClass:",
+	"String:", "BString:", "FString:", "Coverage:", "BCoverage:",
+	"FCoverage:", "Replace:"};
+
+//! \fn static bool startsWith (string_view line, const char *key)
+//! \brief Check if the line, without the leading spaces, starts with key.
+static bool startsWith (string_view line, const char *key)
+{
+	size_t pos = line.find_first_not_of (' ');
+	return (pos != string_view::npos) && (line.compare (pos, strlen (key), key) == 0);
+}
+
+//! \fn int indexGlyphLists (string_view sfdData, size_t linePos, NameTable& names, vector<SfdSpan>& vSpan, SfdTokenizer& tok, GlyphListState& state)
+//! \brief Save the location of the glyph names of the lines, other than
+//! StartChar and Ligature2, that refer to glyphs by name.
+//! \param [in] sfdData Line from the SFD file.
+//! \param [in] linePos Offset of the line in the SFD buffer.
+//! \param [out] names Symbol table to which the glyph names are added.
+//! \param [out] vSpan Location of the glyph names in the SFD buffer.
+//! \param [in] tok Tokenizer for splitting the line.
+//! \param [in,out] state The class list being read.
+//! \returns SUCCESS
+//!
+//! The lines are
+//! -# Substitution2, AlternateSubs2 and MultipleSubs2 lookups of a glyph,
+//! the names follow the quoted subtable name.
+//! -# The class lines following KernClass2 and VKernClass2, " count names".
+//! The number of lines is given by the class counts of KernClass2, a +
+//! after the count means class 0 is listed too.
+//! -# The class lines following MarkAttachClasses and MarkAttachSets,
+//! "\"class name\" count names", one line less than the count.
+//! -# The Class, String, Coverage and Replace lines of contextual lookups.
+//!
+//! The count in the class lines is the length of the names in bytes, it
+//! is saved as a SPAN_COUNT so that the writer can correct it.
+//!
+//! Kerns2 and KernsSLIF lines refer to the glyphs by their position, not
+//! their name, and are left alone.
+int indexGlyphLists (string_view sfdData, size_t linePos, NameTable& names,
+	vector<SfdSpan>& vSpan, SfdTokenizer& tok, GlyphListState& state)
+{
+	string_view tmpStr;
+
+	if (state.classLines > 0)
+	{
+		state.classLines--;
+		size_t countPos = 0;
+		if (state.quoted)
+		{
+			//! Skip the class name.
+			countPos = sfdData.find ('"');
+			countPos = (countPos == string_view::npos) ? countPos
+				: sfdData.find ('"', countPos + 1);
+			if (countPos == string_view::npos)
+			{
+				return SUCCESS;
+			}
+			countPos++;
+		}
+		addCountedNames (sfdData, countPos, linePos, names, vSpan);
+		return SUCCESS;
+	}
+
+	if (startsWith (sfdData, SUBSTITUTION_TEXT)
+		|| startsWith (sfdData, ALTERNATE_TEXT)
+		|| startsWith (sfdData, MULTIPLE_TEXT))
+	{
+		tok.split (sfdData, '"');
+		if (tok.getTok (3, tmpStr) == SUCCESS)
+		{
+			addNameSpans (tmpStr, linePos + tok.getOffset (3), names, vSpan);
+		}
+		return SUCCESS;
+	}
+
+	if (startsWith (sfdData, KERN_CLASS_TEXT)
+		|| startsWith (sfdData, VKERN_CLASS_TEXT))
+	{
+		int firstCount = 0;
+		int secondCount = 0;
+		tok.split (sfdData, ' ');
+		if ((tok.getTok (2, tmpStr) == SUCCESS) && !tmpStr.empty ())
+		{
+			parseInt (tmpStr, firstCount);
+			firstCount -= (tmpStr.back () == '+') ? 0 : 1;
+		}
+		if ((tok.getTok (3, tmpStr) == SUCCESS) && !tmpStr.empty ())
+		{
+			parseInt (tmpStr, secondCount);
+			secondCount -= (tmpStr.back () == '+') ? 0 : 1;
+		}
+		state.classLines = max (firstCount, 0) + max (secondCount, 0);
+		state.quoted = false;
+		return SUCCESS;
+	}
+
+	if (startsWith (sfdData, MARK_CLASSES_TEXT)
+		|| startsWith (sfdData, MARK_SETS_TEXT))
+	{
+		int count = 0;
+		tok.split (sfdData, ' ');
+		if (tok.getTok (2, tmpStr) == SUCCESS)
+		{
+			parseInt (tmpStr, count);
+		}
+		state.classLines = max (count - 1, 0);
+		state.quoted = true;
+		return SUCCESS;
+	}
+
+	unsigned int i;
+	if (state.inFpst)
+	{
+		if (startsWith (sfdData, FPST_END_TEXT))
+		{
+			state.inFpst = false;
+			return SUCCESS;
+		}
+		for (i = 0; i < sizeof (FpstListText) / sizeof (FpstListText[0]); i++)
+		{
+			if (startsWith (sfdData, FpstListText[i]))
+			{
+				size_t countPos = sfdData.find (':') + 1;
+				addCountedNames (sfdData, countPos, linePos, names, vSpan);
+				break;
+			}
+		}
+		return SUCCESS;
+	}
+
+	for (i = 0; i < sizeof (FpstText) / sizeof (FpstText[0]); i++)
+	{
+		if (startsWith (sfdData, FpstText[i]))
+		{
+			state.inFpst = true;
+			break;
+		}
+	}
+	return SUCCESS;
+}
+
+//! \fn int addNameSpans (string_view glyphNames, size_t listPos, NameTable& names, vector<SfdSpan>& vSpan)
+//! \brief Save the location of every glyph name of a list.
+//! \param [in] glyphNames Glyph names separated by spaces.
+//! \param [in] listPos Offset of the list in the SFD buffer.
+//! \param [out] names Symbol table to which the glyph names are added.
+//! \param [out] vSpan Location of the glyph names in the SFD buffer.
+//! \returns The number of names.
+int addNameSpans (string_view glyphNames, size_t listPos, NameTable& names,
+	vector<SfdSpan>& vSpan)
+{
+	size_t pos = 0;
+	int count = 0;
+	while (pos < glyphNames.length ())
+	{
+		if (glyphNames[pos] == ' ')
+		{
+			pos++;
+			continue;
+		}
+
+		size_t end = glyphNames.find (' ', pos);
+		if (end == string_view::npos)
+		{
+			end = glyphNames.length ();
+		}
+
+		SfdSpan span;
+		span.offset = listPos + pos;
+		span.length = end - pos;
+		span.type = SPAN_NAME;
+		span.nameId = names.intern (glyphNames.substr (pos, end - pos));
+		vSpan.push_back (span);
+		count++;
+		pos = end;
+	}
+	return count;
+}
+
+//! \fn int addCountedNames (string_view sfdData, size_t countPos, size_t linePos, NameTable& names, vector<SfdSpan>& vSpan)
+//! \brief Save the location of a byte count and the glyph names it counts.
+//! \param [in] sfdData Line from the SFD file.
+//! \param [in] countPos Offset of the count in the line, it may be
+//! preceded by spaces.
+//! \param [in] linePos Offset of the line in the SFD buffer.
+//! \param [out] names Symbol table to which the glyph names are added.
+//! \param [out] vSpan Location of the count and the names.
+//! \returns SUCCESS if the count is found.
+//! \returns FAIL if there is no count.
+int addCountedNames (string_view sfdData, size_t countPos, size_t linePos,
+	NameTable& names, vector<SfdSpan>& vSpan)
+{
+	size_t start = sfdData.find_first_not_of (' ', countPos);
+	if (start == string_view::npos)
+	{
+		return FAIL;
+	}
+	size_t end = sfdData.find_first_not_of ("0123456789", start);
+	if (end == string_view::npos)
+	{
+		end = sfdData.length ();
+	}
+	if (end == start)
+	{
+		return FAIL;
+	}
+
+	int count = 0;
+	parseInt (sfdData.substr (start, end - start), count);
+
+	SfdSpan span;
+	span.offset = linePos + start;
+	span.length = end - start;
+	span.type = SPAN_COUNT;
+	span.count = 0;
+	size_t countSpan = vSpan.size ();
+	vSpan.push_back (span);
+
+	//! The names follow the count after a space.
+	size_t listStart = end + 1;
+	if ((listStart < sfdData.length ()) && (count > 0))
+	{
+		string_view list = sfdData.substr (listStart, count);
+		vSpan[countSpan].count = addNameSpans (list, linePos + listStart,
+			names, vSpan);
+	}
+	return SUCCESS;
+}
+
+//! \fn int storeLigature (string_view sfdData, NameTable& names, GlyphStore& glyphs, SfdTokenizer& tok)
+//! \brief Add the ligature of the Ligature Line read from the input SFD
+//! file to the store, it belongs to the next glyph added.
+//! \param [in] sfdData Ligature line from the input SFD file.
+//! \param [out] names Symbol table to which the glyph names are added.
+//! \param [in,out] glyphs Store holding the glyph data, the ligature is
+//! added only if the line is valid.
+//! \param [in] tok Tokenizer for splitting the line.
+//! \returns SUCCESS if data is stored successfully.
+//! \returns FAIL if operation fails.
+int storeLigature (string_view sfdData, NameTable& names, GlyphStore& glyphs, SfdTokenizer& tok)
+{
+	//! Extract the form from the SFD line. Form will be enclosed in single
+	//! quotes. The form will be second token when the delimiter is
+	//! single quote.
+	
+	jTRACE ("Store Ligature");
+	string_view form;
+	string_view tmpStr;
+	tok.split (sfdData, '\'');
+	if (tok.getTok (2, form) != SUCCESS)
+	{
+		return FAIL;
+	}
+	//! Extract the names of the glyphs from the end. The glyphs will be 
+	//! the third token if the delimiter is set to double quotes.
+	tok.split (sfdData, '"');
+	if (tok.getTok (3, tmpStr) != SUCCESS)
+	{
+		return FAIL;
+	}
+	glyphs.addLigature (form);
+
+	tok.split (tmpStr, ' ');
+	string_view glyphName;
+	for (unsigned int i = 1; tok.getTok (i, glyphName) == SUCCESS; i++)
+	{
+		if (glyphName.length () == 0)
+		{
+			// Ignore the spaces.
+			continue;
+		}
+		glyphs.addComp (names.intern (glyphName));
+	}
+
+	return SUCCESS;
+}
+
+//! \fn int renameGlyphs (const RefTable& vRefData, NameTable& names, GlyphStore& glyphs, vector<int>& nameMap, int& renCount, RenameStats& stats)
+//! \brief Traverse through the glyph info and identify the glyphs
+//! that need to be renamed.
+//!	\param [in] vRefData Table containing reference data
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] glyphs Store holding the SFD glyph data
+//! \param [in] nameMap The rename map, indexed by the old name ID, holding
+//! the ID of the new name.
+//! \param [out] renCount Number of renames performed
+//! \param [out] stats Rename passes, duplicate checks and suffix retries.
+//! \returns SUCCESS if operation is successful
+//! \returns FAIL if operation is not successful
+//!
+//! Rules of the game:
+//!
+//! -# Glyphs will be renamed as specified in the reference file.
+//! -# Composite glyphs will be renamed based on the constituent ligatures.
+//! The name of the constituent glyphs will be combined to form the new name
+//! of the composite glyph.
+//! -# If there are multiple ligatures for a composite glyph, the one
+//! with akhn will be used.
+//! -# In case of a tie, the ligature with maximum glyphs will be used
+//! for the creation of the new name
+//! -# When two or more glyphs are joined to form new glyph name, the Conjunct
+//! symbols are ignored to keep the name short and readable.
+//! -# If the derived new name is already used in the SFD file, an underscore
+//! followed by a sequence number will be appended to the new name to
+//! avoid conflicts.
+//! -# Certain glyphs need special processing and they are renamed to 
+//! pre defined names. Refer processHalfForms () for details on such glyphs.
+//!
+//! The composite glyphs are resolved in a single sweep over the dependency
+//! graph built from the Ligature2 components. Each composite keeps a count
+//! of its components without a new name and is queued once the count drops
+//! to zero. The queue is ordered by (pass, position in the SFD file), where
+//! pass is the sweep of the file in which the glyph would become ready if
+//! the glyphs were visited repeatedly in file order. This keeps the order
+//! in which the names are handed out, and so the sequence numbers of the
+//! duplicate names, the same as that of repeated passes over the file.
+int renameGlyphs (const RefTable& vRefData, NameTable& names,
+	GlyphStore& glyphs, vector<int>& nameMap, int& renCount,
+	RenameStats& stats)
+{
+
+	unsigned int i;
+
+	renCount = 0;
+	jLOG ("renameGlyphs() : Renaming the Glyphs");
+
+	//! Index of the names in use, for checking duplicate names.
+	NameReserve nameIndex (names, glyphs);
+	for (i = 0; i < glyphs.getCount (); i++)
+	{
+		nameIndex.addGlyph (i);
+	}
+	
+	int conjunct;
+	int zwj;
+	renameBaseGlyphs (vRefData, names, glyphs, nameIndex, nameMap,
+		conjunct, zwj);
+
+	jLOG ("renameGlyphs() : Finished processing base characters");
+	showMap (names, nameMap);
+
+	//! Glyphs sharing the same name in the SFD file get the same new name.
+	vector<vector<unsigned int> > glyphsByName (nameMap.size ());
+	for (i = 0; i < glyphs.getCount (); i++)
+	{
+		int tCurName = glyphs.getCurId (i);
+		glyphsByName[tCurName].push_back (i);
+
+		int tNewName = nameMap[tCurName];
+		if (tNewName != NO_NAME)
+		{
+			jTRACE ("New name found for " << names.getName (tCurName)
+					<< ": " << names.getName (tNewName));
+			// Set the new name of the glyph.
+			nameIndex.setNewId (i, tNewName);
+		}
+	}
+
+	jLOG ("renameGlyphs() : Building the ligature dependency graph");
+
+	//! Composite glyphs waiting for a component, indexed by component ID.
+	vector<vector<unsigned int> > dependents (nameMap.size ());
+	//! Number of components without a new name, per glyph.
+	vector<int> pending (glyphs.getCount (), 0);
+	//! Pass in which the glyph would have been renamed.
+	vector<int> readyPass (glyphs.getCount (), 1);
+	//! Glyphs with all components renamed, ordered by (pass, index).
+	priority_queue<pair<int, unsigned int>, vector<pair<int, unsigned int> >,
+		greater<pair<int, unsigned int> > > readyQueue;
+
+	//! The components of all the ligatures of a glyph are next to each
+	//! other in the component array.
+	const int *comps = glyphs.getComps ();
+	for (i = 0; i < glyphs.getCount (); i++)
+	{
+		int curName = glyphs.getCurId (i);
+
+		// No ligatures or already renamed, skip.
+		if ((glyphs.getLigatureCount (i) == 0) || (nameMap[curName] != NO_NAME))
+		{
+			continue;
+		}
+
+		unsigned int compEnd = glyphs.getCompBegin (glyphs.getLigEnd (i));
+		for (unsigned int k = glyphs.getCompBegin (glyphs.getLigBegin (i));
+			k < compEnd; k++)
+		{
+			if (nameMap[comps[k]] == NO_NAME)
+			{
+				dependents[comps[k]].push_back (i);
+				pending[i]++;
+			}
+		}
+
+		if (pending[i] == 0)
+		{
+			readyQueue.push (make_pair (readyPass[i], i));
+		}
+	}
+
+	jLOG ("renameGlyphs() : Processing the Ligatures");
+
+	int passCount = 0;
+	while (!readyQueue.empty ())
+	{
+		int pass = readyQueue.top ().first;
+		i = readyQueue.top ().second;
+		readyQueue.pop ();
+
+		int curName = glyphs.getCurId (i);
+		int newName;
+
+		jTRACE ("\n");
+		jTRACE ("renameGlyphs() : Processing Ligature : "
+			<< names.getName (curName) << " pass " << pass);
+
+		// A glyph with the same name might have been renamed already.
+		if (nameMap[curName] != NO_NAME)
+		{
+			jTRACE ("[" << names.getName (curName) << "] already renamed to ["
+				<< names.getName (nameMap[curName]) << "]");
+			continue;
+		}
+
+		if (nameGlyph (glyphs, i, names, nameIndex, nameMap, conjunct, zwj,
+			newName, stats) != SUCCESS)
+		{
+			return FAIL;
+		}
+
+		jDBG ("Adding [" << names.getName (curName) << "] and ["
+				<< names.getName (newName) << "]to the map");
+		nameMap[curName] = newName;
+		
+		// Set the new name.
+		vector<unsigned int>& sameName = glyphsByName[curName];
+		for (unsigned int n = 0; n < sameName.size (); n++)
+		{
+			nameIndex.setNewId (sameName[n], newName);
+		}
+		renCount++;
+		if (pass > passCount)
+		{
+			passCount = pass;
+		}
+
+		//! Release the glyphs waiting for this one. A glyph placed before
+		//! this one in the file would have seen the new name only in the
+		//! next pass.
+		vector<unsigned int>& waiting = dependents[curName];
+		for (unsigned int n = 0; n < waiting.size (); n++)
+		{
+			unsigned int d = waiting[n];
+			int dPass = (d < i) ? pass + 1 : pass;
+			if (dPass > readyPass[d])
+			{
+				readyPass[d] = dPass;
+			}
+			pending[d]--;
+			if (pending[d] == 0)
+			{
+				readyQueue.push (make_pair (readyPass[d], d));
+			}
+		}
+	}
+	jLOG ("renameGlyphs() : Finished processing the Ligatures in "
+		<< passCount << " pass(es)");
+	stats.passes += passCount;
+	stats.renamed += renCount;
+	stats.suffixRetries += nameIndex.getRetryCount ();
+
+	//! New names are added to the symbol table while renaming, they are
+	//! not renamed themselves.
+	nameMap.resize (names.getCount (), NO_NAME);
+	showMap (names, nameMap);
+
+	return SUCCESS;
+}
+
+//! \fn int renameBaseGlyphs (const RefTable& vRefData, NameTable& names, GlyphStore& glyphs, NameReserve& nameIndex, vector<int>& nameMap, int& conjunct, int& zwj)
+//! \brief Rename the glyphs with a code point to the names given in the
+//! reference data.
+//!	\param [in] vRefData Table containing reference data
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] glyphs Store holding the SFD glyph data
+//! \param [in] nameIndex Index of the glyph names in use.
+//! \param [in,out] nameMap The rename map, indexed by the old name ID.
+//! \param [out] conjunct ID of the glyph renamed to Conjunct.
+//! \param [out] zwj ID of the glyph renamed to ZWJ.
+//! \returns SUCCESS
+int renameBaseGlyphs (const RefTable& vRefData, NameTable& names,
+	GlyphStore& glyphs, NameReserve& nameIndex, vector<int>& nameMap,
+	int& conjunct, int& zwj)
+{
+	unsigned int i;
+
+	int fcName;
+	int refName;
+
+	//! Rename the characters. Since the Map and reference data are
+	//! not directly connected, have to use the data loaded from
+	//! the SFD file.
+
+	jLOG ("renameGlyphs() : Processing base characters");
+	for (i = 0; i < glyphs.getCount (); i++)
+	{
+		int fcUniVal;
+		fcUniVal = glyphs.getUnicodeVal (i);
+		fcName = glyphs.getCurId (i);
+		if (fcUniVal == -1)
+		{
+			//! Ignore composite characters while renaming base characters.
+			continue;
+		}
+
+		string_view refStr;
+		refName = (vRefData.find (fcUniVal, refStr) == SUCCESS)
+			? names.intern (refStr) : NO_NAME;
+
+		// Name of character from SFD file and corresponding name from
+		// ref file.
+		nameMap[fcName] = refName;
+
+		// Set the new name of the glyph.
+		nameIndex.setNewId (i, refName);
+		jLOG ("Base char " << "old [" << names.getName (fcName) <<
+					"] new [" << names.getName (refName) << "]");
+	}
+
+	//! Find the glyphs renamed to Conjunct and ZWJ. If there are more
+	//! than one, the one with the greatest name is taken.
+	int conjunctId = names.findId (CONJUNCT);
+	int zwjId = names.findId (ZWJ);
+	conjunct = NO_NAME;
+	zwj = NO_NAME;
+	for (i = 0; i < nameMap.size (); i++)
+	{
+		if ((nameMap[i] == NO_NAME) || (nameMap[i] == NO_ID))
+		{
+			continue;
+		}
+
+		if ((nameMap[i] == conjunctId) && ((conjunct == NO_NAME)
+			|| (names.getName (i) > names.getName (conjunct))))
+		{
+			conjunct = i;
+			jTRACE ("Conjunct [" << names.getName (conjunct) << "]");
+		}
+
+		if ((nameMap[i] == zwjId) && ((zwj == NO_NAME)
+			|| (names.getName (i) > names.getName (zwj))))
+		{
+			zwj = i;
+			jTRACE ("Zwj [" << names.getName (zwj) << "]");
+		}
+	}
+
+	return SUCCESS;
+}
+
+//! \fn static string nameStem (const string& name)
+//! \brief Get the name without a _N sequence number at the end.
+static string nameStem (const string& name)
+{
+	size_t pos = name.find_last_not_of ("0123456789");
+	if ((pos == string::npos) || (pos + 1 == name.length ()) || (name[pos] != '_'))
+	{
+		return name;
+	}
+	return name.substr (0, pos);
+}
+
+//! \fn static int touchesBuilt (const string& name, unordered_set<string>& built)
+//! \brief Check if a name could have been tried by checkDups () for one of
+//! the built names, as the name itself or with a sequence number.
+static int touchesBuilt (const string& name, unordered_set<string>& built)
+{
+	if (name.empty ())
+	{
+		return 0;
+	}
+	return (built.count (name) != 0) || (built.count (nameStem (name)) != 0);
+}
+
+//! \fn int reuseNames (const RefTable& vRefData, NameTable& names, GlyphStore& glyphs, NameCache& cache, vector<int>& nameMap, int& renCount, RenameStats& stats)
+//! \brief Build the rename map from the names of the previous run, only
+//! the glyphs that changed since are renamed.
+//!	\param [in] vRefData Table containing reference data
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] glyphs Store holding the SFD glyph data
+//! \param [in] cache The glyphs and names of the previous run.
+//! \param [out] nameMap The rename map, indexed by the old name ID.
+//! \param [out] renCount Number of composite glyphs renamed.
+//! \param [out] stats Glyphs reused, duplicate checks.
+//! \returns SUCCESS if the rename map is the same as renameGlyphs ()
+//! would build.
+//! \returns FAIL if the glyphs have to be renamed by renameGlyphs (). The
+//! rename map and the new names of the glyphs are left half done.
+//!
+//! The Nth glyph with a name is matched with the Nth glyph of that name in
+//! the cache. A glyph is changed if it has no match or its fingerprint is
+//! different, the glyphs that use it in a Ligature2 line are changed too,
+//! and so are the glyphs sharing a name with a changed glyph. The other
+//! glyphs keep their names from the cache.
+//!
+//! The names of the unchanged glyphs are the ones renameGlyphs () would
+//! give only if the changed glyphs do not take part in the duplicate name
+//! checks. So the names are not reused if
+//! -# a StartChar name is used by more than one glyph, the glyphs of a
+//! name are named together and their order decides the name,
+//! -# the unchanged glyphs are not in the same order as before,
+//! -# a changed glyph is, or was, renamed to Conjunct or ZWJ,
+//! -# any name of a changed glyph, old or new, is a name built for an
+//! unchanged glyph or one with a sequence number,
+//! -# the name built for a changed glyph is already taken.
+int reuseNames (const RefTable& vRefData, NameTable& names,
+	GlyphStore& glyphs, NameCache& cache, vector<int>& nameMap,
+	int& renCount, RenameStats& stats)
+{
+	unsigned int i;
+	unsigned int glyphCount = glyphs.getCount ();
+	unsigned int nameCount = nameMap.size ();
+	RenameStats tStats;
+
+	renCount = 0;
+	jLOG ("reuseNames() : Matching the glyphs with the name cache");
+
+	//! Match the glyphs with the cache.
+	vector<int> entryOf (glyphCount, -1);
+	vector<char> matched (cache.getCount (), 0);
+	vector<unsigned int> nth (nameCount, 0);
+	vector<char> nameChanged (nameCount, 0);
+	for (i = 0; i < glyphCount; i++)
+	{
+		int curName = glyphs.getCurId (i);
+		int e = cache.findEntry (names.getName (curName), nth[curName]++);
+		entryOf[i] = e;
+		if (e >= 0)
+		{
+			matched[e] = 1;
+		}
+		if ((e < 0)
+			|| (cache.getEntry (e).fingerprint != glyphs.getFingerprint (i)))
+		{
+			nameChanged[curName] = 1;
+		}
+		if (nth[curName] > 1)
+		{
+			jLOG ("reuseNames() : [" << names.getName (curName)
+				<< "] is the name of more than one glyph");
+			return FAIL;
+		}
+	}
+
+	//! Glyphs removed since the previous run.
+	for (i = 0; i < cache.getCount (); i++)
+	{
+		if (matched[i])
+		{
+			continue;
+		}
+		int oldName = names.findId (cache.getEntry (i).curName);
+		if ((oldName != NO_ID) && ((unsigned int) oldName < nameCount))
+		{
+			nameChanged[oldName] = 1;
+		}
+	}
+
+	//! The glyphs using a changed glyph are changed too.
+	vector<vector<unsigned int> > users (nameCount);
+	const int *comps = glyphs.getComps ();
+	for (i = 0; i < glyphCount; i++)
+	{
+		unsigned int compEnd = glyphs.getCompBegin (glyphs.getLigEnd (i));
+		for (unsigned int k = glyphs.getCompBegin (glyphs.getLigBegin (i));
+			k < compEnd; k++)
+		{
+			users[comps[k]].push_back (i);
+		}
+	}
+	vector<int> work;
+	for (i = 0; i < nameCount; i++)
+	{
+		if (nameChanged[i])
+		{
+			work.push_back (i);
+		}
+	}
+	while (!work.empty ())
+	{
+		int changed = work.back ();
+		work.pop_back ();
+		for (unsigned int n = 0; n < users[changed].size (); n++)
+		{
+			int user = glyphs.getCurId (users[changed][n]);
+			if (!nameChanged[user])
+			{
+				nameChanged[user] = 1;
+				work.push_back (user);
+			}
+		}
+	}
+
+	//! The unchanged glyphs have to be in the same order, it decides the
+	//! order of the duplicate checks.
+	int lastEntry = -1;
+	unsigned int changedCount = 0;
+	unordered_set<string> builtNames;
+	for (i = 0; i < glyphCount; i++)
+	{
+		if (nameChanged[glyphs.getCurId (i)])
+		{
+			changedCount++;
+			continue;
+		}
+		if (entryOf[i] <= lastEntry)
+		{
+			jLOG ("reuseNames() : Glyphs are reordered");
+			return FAIL;
+		}
+		lastEntry = entryOf[i];
+		const string& builtName = cache.getEntry (entryOf[i]).builtName;
+		if (!builtName.empty ())
+		{
+			builtNames.insert (builtName);
+		}
+	}
+	jLOG ("reuseNames() : " << changedCount << " of " << glyphCount
+		<< " glyph(s) changed");
+
+	//! Old names of the changed glyphs.
+	for (i = 0; i < cache.getCount (); i++)
+	{
+		const NameCacheEntry& entry = cache.getEntry (i);
+		int oldName = names.findId (entry.curName);
+		if (matched[i] && !nameChanged[oldName])
+		{
+			continue;
+		}
+		if ((entry.newName == CONJUNCT) || (entry.newName == ZWJ)
+			|| touchesBuilt (entry.curName, builtNames)
+			|| touchesBuilt (entry.newName, builtNames)
+			|| touchesBuilt (entry.builtName, builtNames))
+		{
+			jLOG ("reuseNames() : [" << entry.curName
+				<< "] was part of the duplicate checks");
+			return FAIL;
+		}
+	}
+
+	//! Index of the names in use, for checking duplicate names.
+	NameReserve nameIndex (names, glyphs);
+	for (i = 0; i < glyphCount; i++)
+	{
+		nameIndex.addGlyph (i);
+	}
+
+	int conjunct;
+	int zwj;
+	renameBaseGlyphs (vRefData, names, glyphs, nameIndex, nameMap,
+		conjunct, zwj);
+
+	int conjunctId = names.findId (CONJUNCT);
+	int zwjId = names.findId (ZWJ);
+	vector<vector<unsigned int> > glyphsByName (nameCount);
+	for (i = 0; i < glyphCount; i++)
+	{
+		int curName = glyphs.getCurId (i);
+		glyphsByName[curName].push_back (i);
+		if (nameChanged[curName])
+		{
+			if (((nameMap[curName] != NO_NAME) && ((nameMap[curName] == conjunctId)
+				|| (nameMap[curName] == zwjId)))
+				|| touchesBuilt (names.getName (curName), builtNames)
+				|| touchesBuilt (names.getName (nameMap[curName]), builtNames))
+			{
+				jLOG ("reuseNames() : [" << names.getName (curName)
+					<< "] is part of the duplicate checks");
+				return FAIL;
+			}
+			continue;
+		}
+
+		//! Unchanged, take the names from the cache.
+		const NameCacheEntry& entry = cache.getEntry (entryOf[i]);
+		if (!entry.builtName.empty ())
+		{
+			glyphs.setBuiltId (i, names.intern (entry.builtName));
+		}
+		if ((nameMap[curName] == NO_NAME) && !entry.newName.empty ())
+		{
+			nameMap[curName] = names.intern (entry.newName);
+			if (!entry.builtName.empty ())
+			{
+				renCount++;
+			}
+		}
+		if (names.getName (nameMap[curName]) != entry.newName)
+		{
+			jLOG ("reuseNames() : [" << entry.curName
+				<< "] has another name now");
+			return FAIL;
+		}
+		tStats.reused++;
+	}
+
+	for (i = 0; i < glyphCount; i++)
+	{
+		int tNewName = nameMap[glyphs.getCurId (i)];
+		if (tNewName != NO_NAME)
+		{
+			nameIndex.setNewId (i, tNewName);
+		}
+	}
+
+	jLOG ("reuseNames() : Processing the changed Ligatures");
+
+	//! Rename the changed composite glyphs once their components have new
+	//! names. Without duplicates the order does not matter.
+	vector<vector<unsigned int> > dependents (nameCount);
+	vector<int> pending (glyphCount, 0);
+	queue<unsigned int> readyQueue;
+	for (i = 0; i < glyphCount; i++)
+	{
+		int curName = glyphs.getCurId (i);
+		if (!nameChanged[curName] || (glyphs.getLigatureCount (i) == 0)
+			|| (nameMap[curName] != NO_NAME))
+		{
+			continue;
+		}
+
+		unsigned int compEnd = glyphs.getCompBegin (glyphs.getLigEnd (i));
+		for (unsigned int k = glyphs.getCompBegin (glyphs.getLigBegin (i));
+			k < compEnd; k++)
+		{
+			if (nameMap[comps[k]] == NO_NAME)
+			{
+				dependents[comps[k]].push_back (i);
+				pending[i]++;
+			}
+		}
+		if (pending[i] == 0)
+		{
+			readyQueue.push (i);
+		}
+	}
+
+	while (!readyQueue.empty ())
+	{
+		i = readyQueue.front ();
+		readyQueue.pop ();
+
+		int curName = glyphs.getCurId (i);
+		int newName;
+		if (nameMap[curName] != NO_NAME)
+		{
+			continue;
+		}
+
+		if (nameGlyph (glyphs, i, names, nameIndex, nameMap, conjunct, zwj,
+			newName, tStats) != SUCCESS)
+		{
+			return FAIL;
+		}
+		if ((newName != glyphs.getBuiltId (i))
+			|| touchesBuilt (names.getName (newName), builtNames))
+		{
+			jLOG ("reuseNames() : [" << names.getName (newName)
+				<< "] is part of the duplicate checks");
+			return FAIL;
+		}
+
+		nameMap[curName] = newName;
+		vector<unsigned int>& sameName = glyphsByName[curName];
+		for (unsigned int n = 0; n < sameName.size (); n++)
+		{
+			nameIndex.setNewId (sameName[n], newName);
+		}
+		renCount++;
+
+		vector<unsigned int>& waiting = dependents[curName];
+		for (unsigned int n = 0; n < waiting.size (); n++)
+		{
+			pending[waiting[n]]--;
+			if (pending[waiting[n]] == 0)
+			{
+				readyQueue.push (waiting[n]);
+			}
+		}
+	}
+	jLOG ("reuseNames() : Reused the names of " << tStats.reused
+		<< " glyph(s)");
+	stats.renamed += renCount;
+	stats.dupChecks += tStats.dupChecks;
+	stats.reused += tStats.reused;
+
+	nameMap.resize (names.getCount (), NO_NAME);
+	showMap (names, nameMap);
+
+	return SUCCESS;
+}
+
+//! \fn int selectComps (GlyphStore& glyphs, unsigned int glyph, unsigned int& compBegin, unsigned int& compEnd)
+//! \brief Select the ligature whose glyphs make up the new name.
+//! \param [in] glyphs Store holding the SFD glyph data.
+//! \param [in] glyph Index of the composite glyph.
+//! \param [out] compBegin Position of the first glyph of the selected
+//! ligature in the component array.
+//! \param [out] compEnd Position after its last glyph, the same as
+//! compBegin if no ligature is selected.
+//! \returns SUCCESS if operation is successful
+//! \returns FAIL if operation is not successful
+//!
+//! With only one ligature, it is used as it is. With multiple ligatures,
+//! the akhn form is preferred if it is the last one, otherwise the first
+//! ligature with maximum glyphs is taken.
+int selectComps (GlyphStore& glyphs, unsigned int glyph,
+	unsigned int& compBegin, unsigned int& compEnd)
+{
+	unsigned int ligBegin = glyphs.getLigBegin (glyph);
+	unsigned int ligEnd = glyphs.getLigEnd (glyph);
+	unsigned int maxCount = 0; // Maximum glyphs in a ligature
+	unsigned int selected = ligEnd; // No ligature selected
+
+	for (unsigned int l = ligBegin; l < ligEnd; l++)
+	{
+		unsigned int glyphCount = glyphs.getCompEnd (l) - glyphs.getCompBegin (l);
+		jTRACE ("Processing form ["
+			<< GlyphStore::unpackForm (glyphs.getFormCode (l)) << "]");
+
+		if (glyphCount > maxCount)
+		{
+			// This Ligature has got max glyphs so far.
+			maxCount = glyphCount;
+			selected = l;
+		}
+	}
+
+	if (ligEnd - ligBegin == 1)
+	{
+		// Only one form, straight away rename.
+		jDBG ("Straight rename");
+		selected = ligBegin;
+	}
+	else if ((ligEnd > ligBegin) && (glyphs.getFormCode (ligEnd - 1) == FORM_AKHN))
+	{
+		jDBG ("Multiple ligatures, akhn form being added");
+		selected = ligEnd - 1;
+	}
+	else
+	{
+		jDBG ("Multiple ligatures, max being added");
+	}
+
+	compBegin = 0;
+	compEnd = 0;
+	if (selected != ligEnd)
+	{
+		compBegin = glyphs.getCompBegin (selected);
+		compEnd = glyphs.getCompEnd (selected);
+	}
+	return SUCCESS;
+}
+
+//! \fn int nameGlyph (GlyphStore& glyphs, unsigned int glyph, NameTable& names, NameReserve& nameIndex, vector<int>& nameMap, int conjunct, int zwj, int& newName, RenameStats& stats)
+//! \brief Build a unique new name for a composite glyph.
+//! \param [in,out] glyphs Store holding the SFD glyph data, the built
+//! name of the glyph is set.
+//! \param [in] glyph Index of the glyph to be renamed, all its components
+//! must have new names.
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] nameIndex Index of the glyph names in use.
+//! \param [in] nameMap The rename map, indexed by old name ID.
+//! \param [in] conjunct ID of the glyph renamed to Conjunct.
+//! \param [in] zwj ID of the glyph renamed to ZWJ.
+//! \param [out] newName ID of the new name of the glyph.
+//! \param [in,out] stats Counts the duplicate checks.
+//! \returns SUCCESS if operation is successful
+//! \returns FAIL if operation is not successful
+int nameGlyph (GlyphStore& glyphs, unsigned int glyph, NameTable& names,
+	NameReserve& nameIndex, vector<int>& nameMap, int conjunct, int zwj,
+	int& newName, RenameStats& stats)
+{
+	unsigned int compBegin;
+	unsigned int compEnd;
+	const string& curName = names.getName (glyphs.getCurId (glyph));
+	string builtName;
+
+	if (selectComps (glyphs, glyph, compBegin, compEnd) != SUCCESS)
+	{
+		return FAIL;
+	}
+
+	buildName (names, nameMap, glyphs.getComps () + compBegin,
+		compEnd - compBegin, conjunct, zwj, builtName);
+	newName = names.intern (builtName);
+	glyphs.setBuiltId (glyph, newName);
+
+	jTRACE ("Calling checkDups");
+	jTRACE ("Current glyph is [" << curName << "]");
+	stats.dupChecks++;
+	if (checkDups (nameIndex, glyph, newName) == FAIL)
+	{
+		// Special processing required for some half forms.
+		string hName;
+		if (processHalfForms (curName, builtName, hName) == SUCCESS)
+		{
+			// It was one of those cases that required special processing.
+			newName = glyphs.getCurId (glyph);
+		}
+		else
+		{
+			jLOG ("[" << builtName << "] already taken, appending seq #");
+			newName = nameIndex.nextFree (glyph, newName);
+			jTRACE ("New name with seq # [" << names.getName (newName) << "]");
+		}
+	}
+
+	return SUCCESS;
+}
+
+//! \fn void showMap (NameTable& names, vector<int>& nameMap)
+//! \brief Display the contents of the Rename map
+void showMap (NameTable& names, vector<int>& nameMap)
+{
+	if (JLOGLVL < TRACE)
+	{
+		return;
+	}
+
+	//! Display in the order of the old names.
+	map<string, string> sortedMap;
+	for (unsigned int i = 1; i < nameMap.size (); i++)
+	{
+		sortedMap[names.getName (i)] = names.getName (nameMap[i]);
+	}
+
+	jTRACE ("showMap ()");
+	for (map <string, string>::iterator i = sortedMap.begin ();
+			i != sortedMap.end(); ++i)
+	{
+		jTRACE ((*i).first << ":" << (*i).second);
+	}
+}
+
+//! \fn int buildName (NameTable& names, vector<int>& nameMap, const int *comps, unsigned int compCount, int conjunct, int zwj, string& out)
+//! \brief Build the new name for a glyph.
+//! The new names of the strings are looked up against the Rename map and
+//! creates new name.
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] nameMap The rename map from which the new names will be
+//! looked up
+//! \param [in] comps Name IDs of the glyphs to be renamed.
+//! \param [in] compCount Number of glyphs in comps.
+//! \param [in] conjunct ID of the glyph renamed to Conjunct.
+//! \param [in] zwj ID of the glyph renamed to ZWJ.
+//! \param [out] out The string that will hold the new name.
+//!
+//! -# If the strings are glyph + xx + zwj, it is considered as a chillu
+//! and new new name will be glyph + "cil"
+int buildName (NameTable& names, vector<int>& nameMap, const int *comps,
+	unsigned int compCount, int conjunct, int zwj, string& out)
+{
+	unsigned int i;
+	int zFlag;
+	int cFlag;
+	string newName;
+	int mappedName; // Currently mapped name for the glyph
+
+	//! Glyphs literally named ZWJ, CONJUNCT and xx.
+	int zwjText = names.findId (ZWJ);
+	int conjunctText = names.findId ("CONJUNCT");
+	int xxText = names.findId (CONJUNCT);
+
+	cFlag = 0;
+	zFlag = 0;
+	newName = "";
+
+	for (i = 0; i < compCount; i++)
+	{
+		jTRACE ("i = " << i << " " << names.getName (comps[i]));
+	}
+
+	for (i = 0; i < compCount; i++)
+	{
+		jDBG ("Finding new name for " << names.getName (comps[i]));
+		// Check for Chillu & ZWJ
+		// if (comps[i] == ZWJ) 
+		if ((comps[i] == zwjText) || (comps[i] == zwj))
+		{
+			zFlag++;
+
+			jTRACE ("Found ZWJ case");
+			//! Check if this is a chillu - glyph + xx + zwj. If true, rename
+			//! glyph to glyph + chil
+
+			if ( (i == 2) && (cFlag == 1) && (compCount == 3))
+			{
+				jDBG ("Found chillu comibination for "
+					<< names.getName (comps[0]));
+				// out = comps[0];
+				out.append (CHILLU_NANE);
+			}
+			continue;
+		}
+
+		/*
+		jTRACE ("Conjunct [" << Conjunct << "]");
+		if ((comps[i] == "CONJUNCT") || (comps[i] == Conjunct))
+		{
+			//! If there are only two glyphs and the 2nd one is xx, retain it.
+			jTRACE ("Found Conjunct case");
+			cFlag++;
+
+			jTRACE ("out, before appening virama [" << out << "]");
+			if ( (i == 1) && (compCount == 2))
+			{
+				// out = comps[0];
+				out.append (CONJUNCT);
+			}
+			jTRACE ("Appended Conjunct, now the name is [" << out);
+			continue;
+		}
+		*/
+
+		if ((comps[i] == conjunctText) || (comps[i] == conjunct))
+		{
+			// Skip Conjunct.
+			cFlag++;
+			jTRACE ("Skipping Conjunct");
+			continue;
+		}
+
+		mappedName = nameMap[(comps[i])];
+		if (mappedName != NO_NAME)
+		{
+			if (mappedName == xxText)
+			{
+				// Conjunct, skip it.
+				continue;
+			}
+
+			jDBG ("Named map [" << names.getName (comps[i])
+					<< "] [" << names.getName (mappedName) << "]");
+			newName.append (names.getName (mappedName));
+
+			jDBG ("New Name : [" << newName << "]");
+			out = newName;
+		}
+		else
+		{
+			// Not found in the remap, use the old one itself.
+			newName.append (names.getName (comps[i]));
+			jDBG ("New Name : [" << newName << "]");
+			out = newName;
+		}
+	}
+
+	return (SUCCESS);
+}
+
+
+//! \fn int writeNewSFD (SfdBuffer& sfdBuf, vector<SfdSpan>& vSpan, const char *outFname, int outFd, NameTable& names, vector<int>& nameMap, RenameStats& stats)
+//! \brief Create new SFD file with new glyph names.
+//!
+//! Copy the input SFD data to the output file and rename the glyphs using
+//! the look up table. Only the glyph names recorded in vSpan are looked
+//! up, the data between them is copied as it is.
+//!
+//! The output is a list of segments: the unchanged data of the input
+//! buffer and the new names, which is written with writev () without
+//! copying the unchanged data. The byte counts of the class lists are
+//! corrected for the length of the new names.
+//! \param [in] sfdBuf Contents of the input SFD file.
+//! \param [in] vSpan Location of the glyph names in sfdBuf.
+//! \param [in] outFname Name of the output SFD file, STDIO_NAME writes
+//! to stdout.
+//! \param [in] outFd Open output file used instead of outFname, -1 to
+//! create outFname.
+//! \param [in] names Symbol table of the glyph names.
+//! \param [in] nameMap The lookup table for new glyph names.
+//! \param [out] stats Bytes written.
+int writeNewSFD (SfdBuffer& sfdBuf, vector<SfdSpan>& vSpan, const char *outFname, int outFd, NameTable& names, vector<int>& nameMap, RenameStats& stats)
+{
+	const char *sfdData = sfdBuf.getData (); // Data from the input SFD file.
+	size_t sfdSize = sfdBuf.getSize ();
+	size_t copyPos; // Start of the data yet to be copied.
+	size_t outSize = 0;
+	deque<string> newCounts; // Corrected byte counts, they must not move.
+
+	jLOG ("Writing new SFD file");
+
+	vector<struct iovec> segments;
+	segments.reserve (vSpan.size () + 2);
+	copyPos = 0;
+	for (unsigned int i = 0; i < vSpan.size (); i++)
+	{
+		const string *text = NULL;
+		if (vSpan[i].type == SPAN_COUNT)
+		{
+			//! Add the change in the length of the names counted.
+			long delta = 0;
+			for (int n = 1; (n <= vSpan[i].count) && (i + n < vSpan.size ()); n++)
+			{
+				int newName = spanNewName (vSpan[i + n], nameMap);
+				if (newName != NO_NAME)
+				{
+					delta += (long) names.getName (newName).length ()
+						- (long) vSpan[i + n].length;
+				}
+			}
+			if (delta != 0)
+			{
+				int count = 0;
+				parseInt (string_view (sfdData + vSpan[i].offset,
+					vSpan[i].length), count);
+				newCounts.push_back (to_string (count + delta));
+				text = &newCounts.back ();
+			}
+		}
+		else
+		{
+			//! Replace the name if the new name is different, otherwise
+			//! the old name is copied.
+			int newName = spanNewName (vSpan[i], nameMap);
+			if (newName != NO_NAME)
+			{
+				jTRACE ("Found new name for ["
+					<< names.getName (vSpan[i].nameId) << "] = ["
+					<< names.getName (newName) << "]");
+				text = &names.getName (newName);
+			}
+		}
+		if (text == NULL)
+		{
+			continue;
+		}
+
+		//! Copy the data up to the span, then the new text.
+		addSegment (segments, sfdData + copyPos, vSpan[i].offset - copyPos);
+		addSegment (segments, text->data (), text->length ());
+		copyPos = vSpan[i].offset + vSpan[i].length;
+	}
+	addSegment (segments, sfdData + copyPos, sfdSize - copyPos);
+
+	//! Every line in the output is terminated by a new line.
+	if ((sfdSize > 0) && (sfdData[sfdSize - 1] != '\n'))
+	{
+		addSegment (segments, "\n", 1);
+	}
+
+	if (writeOutput (outFname, outFd, segments, outSize) != SUCCESS)
+	{
+		return FAIL;
+	}
+	stats.outBytes += outSize;
+	stats.write.bytes += outSize;
+	jLOG ("Finished Writing new SFD file");
+
+	return SUCCESS;
+}
+
+//! \fn int rewriteText (SfdBuffer& textBuf, const RenameMap& renameMap, const char *outFname, int outFd, int& renCount, RenameStats& stats)
+//! \brief Rename the glyph names of a text file using the rename map.
+//!
+//! The file is not parsed, every word of it is looked up in the map. The
+//! words are separated by white space and the punctuation of feature
+//! files and scripts, []{}()<>;,=\\ and quotes, so that [ka kka], ka'
+//! and "ka" are all renamed. Other words, such as @classes and a-z
+//! ranges, are copied as they are.
+//! \param [in] textBuf Contents of the input file.
+//! \param [in] renameMap The glyphs to rename.
+//! \param [in] outFname Name of the output file, STDIO_NAME writes to
+//! stdout.
+//! \param [in] outFd Open output file used instead of outFname, -1 to
+//! create outFname.
+//! \param [out] renCount Number of words renamed.
+//! \param [out] stats Bytes written.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the output file cannot be written.
+int rewriteText (SfdBuffer& textBuf, const RenameMap& renameMap,
+	const char *outFname, int outFd, int& renCount, RenameStats& stats)
+{
+	static const vector<bool> isDelim = [] ()
+		{
+			vector<bool> delims (256, false);
+			for (const char *c = TEXT_DELIMS; *c != '\0'; c++)
+			{
+				delims[(unsigned char) *c] = true;
+			}
+			return delims;
+		} ();
+
+	const char *textData = textBuf.getData ();
+	size_t textSize = textBuf.getSize ();
+	size_t copyPos = 0; // Start of the data yet to be copied.
+	size_t outSize = 0;
+	vector<struct iovec> segments;
+
+	jLOG ("Writing renamed text file");
+	renCount = 0;
+	size_t pos = 0;
+	while (pos < textSize)
+	{
+		if (isDelim[(unsigned char) textData[pos]])
+		{
+			pos++;
+			continue;
+		}
+		size_t wordPos = pos;
+		while ((pos < textSize) && !isDelim[(unsigned char) textData[pos]])
+		{
+			pos++;
+		}
+		const string *newName = renameMap.findName (
+			string_view (textData + wordPos, pos - wordPos));
+		if (newName == NULL)
+		{
+			continue;
+		}
+		addSegment (segments, textData + copyPos, wordPos - copyPos);
+		addSegment (segments, newName->data (), newName->length ());
+		copyPos = pos;
+		renCount++;
+	}
+	addSegment (segments, textData + copyPos, textSize - copyPos);
+
+	if (writeOutput (outFname, outFd, segments, outSize) != SUCCESS)
+	{
+		return FAIL;
+	}
+	stats.outBytes += outSize;
+	stats.write.bytes += outSize;
+	return SUCCESS;
+}
+
+//! \fn int writeOutput (const char *outFname, int outFd, vector<struct iovec>& segments, size_t& written)
+//! \brief Create the output file and write the segments to it.
+//! \param [in] outFname Name of the output file, STDIO_NAME writes to
+//! stdout.
+//! \param [in] outFd Open output file used instead of outFname, -1 to
+//! create outFname. It is left open.
+//! \param [in,out] segments The data, the segments are consumed.
+//! \param [out] written Bytes written.
+//! \returns SUCCESS if all the data is written.
+//! \returns FAIL if the file cannot be opened or written.
+int writeOutput (const char *outFname, int outFd,
+	vector<struct iovec>& segments, size_t& written)
+{
+	//! Only the file opened here is closed.
+	int fd = outFd;
+	if (fd < 0)
+	{
+		fd = (strcmp (outFname, STDIO_NAME) == 0) ? STDOUT_FILENO
+			: open (outFname, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	}
+	bool keepOpen = (fd == outFd) || (fd == STDOUT_FILENO);
+	if (fd < 0)
+	{
+		jERR ("Uanble to open output file " <<  outFname);
+		return FAIL;
+	}
+	int retVal = writeSegments (fd, segments, written);
+	if (!keepOpen && (close (fd) != 0))
+	{
+		retVal = FAIL;
+	}
+	if (retVal != SUCCESS)
+	{
+		jERR ("Error writing output file " << outFname << " : "
+			<< strerror (errno));
+		return FAIL;
+	}
+	return SUCCESS;
+}
+
+//! \fn int spanNewName (SfdSpan& span, vector<int>& nameMap)
+//! \brief Get the new name of the glyph name span.
+//! \param [in] span A SPAN_STARTCHAR or SPAN_NAME span.
+//! \param [in] nameMap The lookup table for new glyph names.
+//! \returns ID of the new name, NO_NAME if the name is not changed.
+int spanNewName (SfdSpan& span, vector<int>& nameMap)
+{
+	if ((span.nameId < 0) || ((unsigned int) span.nameId >= nameMap.size ()))
+	{
+		return NO_NAME;
+	}
+	int newName = nameMap[span.nameId];
+	return (newName == span.nameId) ? NO_NAME : newName;
+}
+
+//! \fn void addSegment (vector<struct iovec>& segments, const char *data, size_t length)
+//! \brief Add the data to the output, joined with the previous segment
+//! if it follows it in memory.
+void addSegment (vector<struct iovec>& segments, const char *data, size_t length)
+{
+	if (length == 0)
+	{
+		return;
+	}
+	if (!segments.empty ())
+	{
+		struct iovec& prev = segments.back ();
+		if ((const char *) prev.iov_base + prev.iov_len == data)
+		{
+			prev.iov_len += length;
+			return;
+		}
+	}
+	struct iovec seg;
+	seg.iov_base = (void *) data;
+	seg.iov_len = length;
+	segments.push_back (seg);
+}
+
+//! \fn int writeSegments (int fd, vector<struct iovec>& segments, size_t& written)
+//! \brief Write the segments to the file, IOV_MAX at a time.
+//! \param [in] fd The output file.
+//! \param [in,out] segments The data, the segments are consumed.
+//! \param [out] written Bytes written.
+//! \returns SUCCESS if all the data is written.
+//! \returns FAIL if writev () failed, errno is set.
+int writeSegments (int fd, vector<struct iovec>& segments, size_t& written)
+{
+	size_t pos = 0;
+	written = 0;
+	while (pos < segments.size ())
+	{
+		int batch = min ((size_t) IOV_MAX, segments.size () - pos);
+		ssize_t n = writev (fd, &segments[pos], batch);
+		if (n < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return FAIL;
+		}
+		written += n;
+
+		//! Skip the segments written, a short write leaves a part of one.
+		while ((n > 0) && (pos < segments.size ()))
+		{
+			if ((size_t) n < segments[pos].iov_len)
+			{
+				segments[pos].iov_base = (char *) segments[pos].iov_base + n;
+				segments[pos].iov_len -= n;
+				break;
+			}
+			n -= segments[pos].iov_len;
+			pos++;
+		}
+	}
+	return SUCCESS;
+}
+
+//! \fn int checkDups (NameReserve& nameIndex, unsigned int glyph, int newName)
+//! \brief Check if the new name is already taken
+//! \param [in] nameIndex Index of the glyph names in use.
+//! \param [in] glyph Index of the glyph being renamed.
+//! \param [in] newName ID of the new name for the glyph.
+//! \returns FAIL if the name is already in use.
+//!
+//! Both current and new names of the other glyphs are checked.
+int checkDups (NameReserve& nameIndex, unsigned int glyph, int newName)
+{
+	jTRACE ("Checking for existing name ID [" << newName << "]");
+	if (nameIndex.isTaken (glyph, newName))
+	{
+		//! If found being used, return fail.
+		jDBG ("Name ID already exists [" << newName << "]");
+		return FAIL;
+	}
+	
+	//! The new name is not being used, return SUCCESS.
+	jTRACE ("checkDups returning SUCCESS");
+	return SUCCESS;
+}
+
+//! \fn int processHalfForms (string curName, string newName, string& hName)
+//! \brief Alternate naming method for some special glyphs
+//! \param [in] curName Current glyph name.
+//!	\param [in] newName New name built for the glyph.
+//! \param [out] hName The final new name.
+//! \returns SUCCESS if alternate name is found.
+//! \returns FAIL if alternate name is not found.
+//!
+//! Few glyphs need special naming, they are listed here:
+//! Old Names | New Name
+//! ----------|---------
+//! y1        | y2
+//! y1xx      | y2
+//! r3        | r4
+//! r3xx      | r4
+//! l3        | l4
+//! l3xx      | l4
+//! v1        | v2
+//! v1xx      | v2
+
+int processHalfForms (string curName, string newName, string& hName)
+{
+	map<string, string> specials;
+
+	jTRACE ("processHalfForms [" << curName << "] [" << newName <<"]");
+
+	specials["y1"] = "y2";
+	specials["y1xx"] = "y2";
+	specials["r3"] = "r4";
+	specials["r3xx"] = "r4";
+	specials["l3"] = "l4";
+	specials["l3xx"] = "l4";
+	specials["v1"] = "v2";
+	specials["v1xx"] = "v2";
+
+	if (specials[newName] == curName)
+	{
+		hName = curName;
+		jTRACE ("Setting special to [" << hName << "]");
+		return SUCCESS;
+	}
+
+	return FAIL;
+}
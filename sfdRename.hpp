@@ -0,0 +1,165 @@
+#ifndef __SFDRENAME_H
+#define __SFDRENAME_H
+using namespace std;
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <sys/uio.h>
+#include "fontClass.hpp"
+#include "sfdBuffer.hpp"
+#include "sfdTok.hpp"
+#include "refTable.hpp"
+#include "runStats.hpp"
+#include "nameCache.hpp"
+#include "renameMap.hpp"
+//! \file sfdRename.hpp
+//! \brief Phases of renaming the glyphs of a SFD file.
+
+//! Options for renaming a font.
+struct RenameOptions
+{
+	//! Reuse the names of the previous run from the name cache next to
+	//! the output file, and update the cache.
+	bool useCache = false;
+
+	//! Threads parsing the SFD file, 1 parses it on the calling thread.
+	unsigned int fontThreads = 1;
+
+	//! File the resolved names are exported to as a RenameMap, empty for
+	//! none.
+	string exportMap;
+
+	//! Open input file read instead of the input file name, -1 to open
+	//! the file. The name is still used in the messages.
+	int inFd = -1;
+
+	//! Open output file written instead of the output file name, -1 to
+	//! create the file.
+	int outFd = -1;
+
+	//! Fail the font if a StartChar name is used by several glyphs of the
+	//! input, or a new name is given to glyphs of different names.
+	bool strict = false;
+};
+
+//! Characters separating the words of a text file renamed with a
+//! RenameMap.
+#define TEXT_DELIMS " \t\r\n\f\v[]{}()<>;,=\\\"'"
+
+//! Smallest chunk of the SFD file parsed by a thread, in bytes.
+#define MIN_CHUNK_SIZE (256 * 1024)
+
+//! Duplicate glyph names reported for a font, the others are only counted.
+#define DUP_MAX_REPORTS 20
+
+//! The class list being read by indexGlyphLists ().
+struct GlyphListState
+{
+	int classLines = 0; //!< Class lines yet to be read.
+	bool quoted = false; //!< The class lines start with a quoted name.
+	bool inFpst = false; //!< Within a contextual lookup.
+};
+
+//! A part of the SFD file parsed by one thread.
+//! Every chunk but the first starts at a StartChar line. The glyphs are
+//! added to a NameTable of the chunk and moved to the NameTable of the
+//! font once all the chunks are parsed.
+struct SfdChunk
+{
+	size_t begin; //!< Offset of the first line of the chunk.
+	size_t end; //!< Offset of the line after the chunk.
+	NameTable names; //!< Names found in the chunk.
+	GlyphStore glyphs; //!< Glyphs of the chunk.
+	vector<SfdSpan> vSpan; //!< Location of the glyph names in the chunk.
+	RenameStats stats; //!< Lines, glyphs and ligatures of the chunk.
+	int result = FAIL; //!< Return value of analyzeChunk ().
+	bool carryIn = false; //!< A glyph has no Encoding line before EndChar.
+	bool carryOut = false; //!< Lines of a glyph follow the last EndChar.
+};
+
+//! Rename the glyphs of one SFD file, runs all the phases below.
+int renameFont (const RefTable& vRefData, const string& inFile, const string& outFile, const RenameOptions& options, RenameStats& stats);
+
+//! Rename the glyphs of a SFD or text file using an exported rename map.
+int applyRenameMap (const RenameMap& renameMap, const string& inFile, const string& outFile, const RenameOptions& options, RenameStats& stats);
+
+//! Load the reference data, from the binary cache if it is current.
+int loadReferenceData (const char *refFile, RefTable& ref);
+
+//! Load the glyph names and ligatures from the SFD file.
+int analyzeSFDFile (SfdBuffer& sfdBuf, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats, unsigned int threads);
+
+//! Find the StartChar names used by more than one glyph.
+unsigned long findDupGlyphs (NameTable& names, GlyphStore& glyphs);
+
+//! Find the new names given to glyphs of different names.
+unsigned long findNewDups (NameTable& names, GlyphStore& glyphs, vector<int>& nameMap);
+
+//! Load the glyph names and ligatures from a part of the SFD file.
+int analyzeChunk (SfdBuffer& sfdBuf, size_t begin, size_t end, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats, bool& carryIn, bool& carryOut);
+
+//! Split the SFD file into chunks at StartChar lines.
+int splitChunks (SfdBuffer& sfdBuf, unsigned int count, vector<size_t>& bounds);
+
+//! Move the glyphs of the parsed chunks to the font, in file order.
+int mergeChunks (vector<unique_ptr<SfdChunk> >& chunks, NameTable& names, GlyphStore& glyphs, vector<SfdSpan>& vSpan, RenameStats& stats);
+
+//! Save the location of the glyph names of the other lines naming glyphs.
+int indexGlyphLists (string_view sfdData, size_t linePos, NameTable& names, vector<SfdSpan>& vSpan, SfdTokenizer& tok, GlyphListState& state);
+
+//! Save the location of every glyph name of a list.
+int addNameSpans (string_view glyphNames, size_t listPos, NameTable& names, vector<SfdSpan>& vSpan);
+
+//! Save the location of a byte count and the glyph names it counts.
+int addCountedNames (string_view sfdData, size_t countPos, size_t linePos, NameTable& names, vector<SfdSpan>& vSpan);
+
+//! Load the glyph names of a Ligature2 line.
+int storeLigature (string_view sfdData, NameTable& names, GlyphStore& glyphs, SfdTokenizer& tok);
+
+//! Build the rename map.
+int renameGlyphs (const RefTable& vRefData, NameTable& names, GlyphStore& glyphs, vector<int>& nameMap, int& renCount, RenameStats& stats);
+
+//! Rename the glyphs that have a code point in the reference data.
+int renameBaseGlyphs (const RefTable& vRefData, NameTable& names, GlyphStore& glyphs, NameReserve& nameIndex, vector<int>& nameMap, int& conjunct, int& zwj);
+
+//! Build the rename map from the names of the previous run.
+int reuseNames (const RefTable& vRefData, NameTable& names, GlyphStore& glyphs, NameCache& cache, vector<int>& nameMap, int& renCount, RenameStats& stats);
+
+//! Select the ligature whose glyphs make up the new name.
+int selectComps (GlyphStore& glyphs, unsigned int glyph, unsigned int& compBegin, unsigned int& compEnd);
+
+//! Build a unique new name for a composite glyph.
+int nameGlyph (GlyphStore& glyphs, unsigned int glyph, NameTable& names, NameReserve& nameIndex, vector<int>& nameMap, int conjunct, int zwj, int& newName, RenameStats& stats);
+
+//! Display the contents of the rename map.
+void showMap (NameTable& names, vector<int>& nameMap);
+
+//! Build the new name from the new names of the components.
+int buildName (NameTable& names, vector<int>& nameMap, const int *comps, unsigned int compCount, int conjunct, int zwj, string& out);
+
+//! Write the SFD file with the new glyph names.
+int writeNewSFD (SfdBuffer& sfdBuf, vector<SfdSpan>& vSpan, const char *outFile, int outFd, NameTable& names, vector<int>& nameMap, RenameStats& stats);
+
+//! Rename the words of a text file found in the rename map.
+int rewriteText (SfdBuffer& textBuf, const RenameMap& renameMap, const char *outFile, int outFd, int& renCount, RenameStats& stats);
+
+//! Create the output file and write the segments to it.
+int writeOutput (const char *outFile, int outFd, vector<struct iovec>& segments, size_t& written);
+
+//! Get the new name of a glyph name span.
+int spanNewName (SfdSpan& span, vector<int>& nameMap);
+
+//! Add a block of data to the output segments.
+void addSegment (vector<struct iovec>& segments, const char *data, size_t length);
+
+//! Write the output segments to the file.
+int writeSegments (int fd, vector<struct iovec>& segments, size_t& written);
+
+//! Check if the new name is already taken.
+int checkDups (NameReserve& nameIndex, unsigned int glyph, int newName);
+
+//! Special names for some half forms.
+int processHalfForms (string curName, string newName, string& hName);
+
+#endif
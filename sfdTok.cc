@@ -0,0 +1,161 @@
+#include <limits.h>
+#include <string.h>
+#include "sfdTok.hpp"
+#include "fontClass.hpp"
+//! \file sfdTok.cc
+//! \brief SfdTokenizer implementation and number parsers.
+
+//! \fn unsigned int SfdTokenizer::split (string_view inLine, char delim)
+//! \brief Split the line into tokens in a single pass.
+//! \param [in] inLine The line to be split.
+//! \param [in] delim The delimiter.
+//! \returns Number of tokens.
+unsigned int SfdTokenizer::split (string_view inLine, char delim)
+{
+	line = inLine;
+	toks.clear ();
+
+	const char *start = line.data ();
+	const char *end = start + line.size ();
+	const char *next = (const char *) memchr (start, delim, line.size ());
+	if (next == NULL)
+	{
+		// The delimiter was not present in the line.
+		return 0;
+	}
+
+	while (next != NULL)
+	{
+		toks.push_back (string_view (start, next - start));
+		start = next + 1;
+		next = (const char *) memchr (start, delim, end - start);
+	}
+	if (start != end)
+	{
+		toks.push_back (string_view (start, end - start));
+	}
+	return toks.size ();
+}
+
+//! \fn int SfdTokenizer::getTok (unsigned int pos, string_view& out)
+//! \brief Get the token at pos.
+//! \param [in] pos Position of the token, starting from 1.
+//! \param [out] out The token.
+//! \returns SUCCESS if the token is present.
+//! \returns FAIL if there are less than pos tokens.
+int SfdTokenizer::getTok (unsigned int pos, string_view& out)
+{
+	if ((pos == 0) || (pos > toks.size ()))
+	{
+		return FAIL;
+	}
+	out = toks[pos - 1];
+	return SUCCESS;
+}
+
+//! Get the number of tokens.
+unsigned int SfdTokenizer::getCount (void)
+{
+	return toks.size ();
+}
+
+//! Get the offset of the token at pos (starting from 1) in the line.
+size_t SfdTokenizer::getOffset (unsigned int pos)
+{
+	return toks[pos - 1].data () - line.data ();
+}
+
+//! \fn int parseInt (string_view str, int& val)
+//! \brief Convert a decimal string to int.
+//! Leading white spaces and a sign are accepted, the conversion stops at
+//! the first character that is not a digit.
+//! \param [in] str The string.
+//! \param [out] val The value, 0 if there are no digits.
+//! \returns SUCCESS if at least one digit is found.
+//! \returns FAIL if there are no digits.
+int parseInt (string_view str, int& val)
+{
+	size_t i = 0;
+	int neg = 0;
+	long n = 0;
+
+	while ((i < str.size ()) && ((str[i] == ' ') || (str[i] == '\t')))
+	{
+		i++;
+	}
+	if ((i < str.size ()) && ((str[i] == '-') || (str[i] == '+')))
+	{
+		neg = (str[i] == '-');
+		i++;
+	}
+
+	size_t digits = i;
+	while ((i < str.size ()) && (str[i] >= '0') && (str[i] <= '9'))
+	{
+		if (n <= INT_MAX)
+		{
+			n = n * 10 + (str[i] - '0');
+		}
+		i++;
+	}
+	if (n > INT_MAX)
+	{
+		n = INT_MAX;
+	}
+	val = neg ? (int) -n : (int) n;
+	return (i > digits) ? SUCCESS : FAIL;
+}
+
+//! \fn int parseHex (string_view str, int& val)
+//! \brief Convert a hex string to int.
+//! Leading white spaces and a 0x or 0X prefix are accepted, the
+//! conversion stops at the first character that is not a hex digit.
+//! \param [in] str The string.
+//! \param [out] val The value, 0 if there are no hex digits.
+//! \returns SUCCESS if at least one hex digit is found.
+//! \returns FAIL if there are no hex digits.
+int parseHex (string_view str, int& val)
+{
+	size_t i = 0;
+	unsigned long n = 0;
+
+	while ((i < str.size ()) && ((str[i] == ' ') || (str[i] == '\t')))
+	{
+		i++;
+	}
+	if ((i + 1 < str.size ()) && (str[i] == '0')
+		&& ((str[i + 1] == 'x') || (str[i + 1] == 'X')))
+	{
+		i += 2;
+	}
+
+	size_t digits = i;
+	while (i < str.size ())
+	{
+		char c = str[i];
+		int d;
+		if ((c >= '0') && (c <= '9'))
+		{
+			d = c - '0';
+		}
+		else if ((c >= 'a') && (c <= 'f'))
+		{
+			d = c - 'a' + 10;
+		}
+		else if ((c >= 'A') && (c <= 'F'))
+		{
+			d = c - 'A' + 10;
+		}
+		else
+		{
+			break;
+		}
+		if (n <= INT_MAX)
+		{
+			n = n * 16 + d;
+		}
+		i++;
+	}
+	val = (n > INT_MAX) ? INT_MAX : (int) n;
+	return (i > digits) ? SUCCESS : FAIL;
+}
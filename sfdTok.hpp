@@ -0,0 +1,43 @@
+#ifndef __SFDTOK_H
+#define __SFDTOK_H
+using namespace std;
+#include <string_view>
+#include <vector>
+//! \file sfdTok.hpp
+//! \brief Tokenizer for the lines of SFD and reference files.
+
+//! Splits a line into tokens separated by a delimiter.
+//! The tokens are views into the line, the line has to outlive them. The
+//! token list is reused between lines, so once it has grown to the
+//! largest line no memory is allocated.
+//!
+//! The tokens are the same as the ones returned by getline () with the
+//! delimiter: consecutive delimiters give empty tokens, a delimiter at
+//! the end of the line does not. A line without the delimiter has no
+//! tokens at all.
+class SfdTokenizer
+{
+public:
+	//! Split the line into tokens, returns the number of tokens.
+	unsigned int split (string_view line, char delim);
+
+	//! Get the token at pos, starting from 1.
+	int getTok (unsigned int pos, string_view& out);
+
+	//! Get the number of tokens.
+	unsigned int getCount (void);
+
+	//! Get the offset of the token at pos from the start of the line.
+	size_t getOffset (unsigned int pos);
+private:
+	string_view line; //!< The line being tokenized
+	vector<string_view> toks; //!< Tokens of the line
+};
+
+//! Convert a decimal string to int, the same way as atoi ().
+int parseInt (string_view str, int& val);
+
+//! Convert a hex string, with or without 0x, to int.
+int parseHex (string_view str, int& val);
+
+#endif
@@ -0,0 +1,445 @@
+#include <string>
+#include <algorithm>
+#include <string.h>
+#include "sfdVerify.hpp"
+#include "sfdRename.hpp"
+#include "sfdTok.hpp"
+#include "jlog.hpp"
+//! \file sfdVerify.cc
+//! \brief SfdVerifier implementation
+
+//! \fn static size_t lineOf (VerifySide& side, size_t offset)
+//! \brief Get the line number of an offset of the file, for the messages.
+//! The lines are counted on from the previous offset asked for, the
+//! checks ask for increasing offsets so the file is scanned once.
+static size_t lineOf (VerifySide& side, size_t offset)
+{
+	const char *data = side.sfdBuf.getData ();
+	if (offset < side.lineOffset)
+	{
+		side.lineOffset = 0;
+		side.lineCount = 1;
+	}
+	const char *pos = data + side.lineOffset;
+	const char *end = data + offset;
+	while ((pos = (const char *) memchr (pos, '\n', end - pos)) != NULL)
+	{
+		side.lineCount++;
+		pos++;
+	}
+	side.lineOffset = offset;
+	return side.lineCount;
+}
+
+//! \fn static size_t firstDiff (const char *a, size_t aLength, const char *b, size_t bLength)
+//! \brief Get the offset of the first byte that differs in two blocks.
+//! \returns The offset, the length of the shorter block if it is a prefix
+//! of the other.
+static size_t firstDiff (const char *a, size_t aLength, const char *b,
+	size_t bLength)
+{
+	size_t length = min (aLength, bLength);
+	size_t pos = 0;
+	while ((pos < length) && (a[pos] == b[pos]))
+	{
+		pos++;
+	}
+	return pos;
+}
+
+//! Create a verifier for a pair of files.
+SfdVerifier::SfdVerifier () : renamed (0), compared (0), mismatches (0)
+{
+}
+
+//! \fn int SfdVerifier::verify (const string& inFile, const string& outFile, unsigned int threads)
+//! \brief Check that outFile is the input file with the glyphs renamed.
+//! Every mismatch is counted, the first VERIFY_MAX_REPORTS are logged.
+//! A verifier checks a single pair of files.
+//! \param [in] inFile The input SFD file of the run.
+//! \param [in] outFile The output SFD file of the run.
+//! \param [in] threads Number of threads parsing each file.
+//! \returns SUCCESS if the files match.
+//! \returns FAIL if a file cannot be read or the files do not match.
+int SfdVerifier::verify (const string& inFile, const string& outFile,
+	unsigned int threads)
+{
+	jLOG ("Verifying " << outFile << " against " << inFile);
+	if ((load (in, inFile, threads) != SUCCESS)
+		|| (load (out, outFile, threads) != SUCCESS))
+	{
+		return FAIL;
+	}
+
+	nameMap.assign (in.names.getCount (), NO_ID);
+	reverseMap.assign (out.names.getCount (), NO_ID);
+
+	//! The other checks need the glyphs paired.
+	if (checkGlyphs () == SUCCESS)
+	{
+		checkLigatures ();
+		checkSpans ();
+	}
+
+	if (mismatches > VERIFY_MAX_REPORTS)
+	{
+		jERR (mismatches - VERIFY_MAX_REPORTS
+			<< " more mismatch(es) not reported");
+	}
+	jLOG ("Verified " << getGlyphCount () << " glyph(s), "
+		<< mismatches << " mismatch(es)");
+	return (mismatches == 0) ? SUCCESS : FAIL;
+}
+
+//! \fn int SfdVerifier::load (VerifySide& side, const string& fileName, unsigned int threads)
+//! \brief Load and parse a SFD file.
+//! \param [out] side The contents and glyphs of the file.
+//! \param [in] fileName Name of the file.
+//! \param [in] threads Number of threads parsing the file.
+//! \returns SUCCESS if operation is successful.
+//! \returns FAIL if the file cannot be read or parsed.
+int SfdVerifier::load (VerifySide& side, const string& fileName,
+	unsigned int threads)
+{
+	RenameStats stats;
+
+	side.fileName = fileName;
+	if (side.sfdBuf.loadFile (fileName.c_str ()) != SUCCESS)
+	{
+		jERR ("Error : Unable to load SFD file " << fileName);
+		return FAIL;
+	}
+	if (analyzeSFDFile (side.sfdBuf, side.names, side.glyphs, side.vSpan,
+		stats, threads) != SUCCESS)
+	{
+		jERR ("Error : analyzeSFDFile failed for " << fileName);
+		return FAIL;
+	}
+	return SUCCESS;
+}
+
+//! \fn int SfdVerifier::checkGlyphs (void)
+//! \brief Pair the glyphs of the files in file order and build the name
+//! map from their names.
+//! \returns SUCCESS if the files have the same number of glyphs.
+//! \returns FAIL if the glyphs cannot be paired.
+//!
+//! Glyphs sharing a name in the input must share the new name, and
+//! glyphs with different names must get different names.
+int SfdVerifier::checkGlyphs (void)
+{
+	unsigned int count = in.glyphs.getCount ();
+	if (count != out.glyphs.getCount ())
+	{
+		mismatch ("Glyph count differs, " + to_string (count)
+			+ " in the input and " + to_string (out.glyphs.getCount ())
+			+ " in the output");
+		return FAIL;
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		int inId = in.glyphs.getCurId (i);
+		int outId = out.glyphs.getCurId (i);
+		if ((nameMap[inId] == NO_ID) && (reverseMap[outId] == NO_ID))
+		{
+			nameMap[inId] = outId;
+			reverseMap[outId] = inId;
+			if (in.names.getName (inId) != out.names.getName (outId))
+			{
+				renamed++;
+			}
+			continue;
+		}
+
+		if (nameMap[inId] == outId)
+		{
+			continue;
+		}
+		if (nameMap[inId] != NO_ID)
+		{
+			if (!countOnly ())
+			{
+				mismatch ("Glyph [" + in.names.getName (inId) + "] is renamed to ["
+					+ out.names.getName (nameMap[inId]) + "] and to ["
+					+ out.names.getName (outId) + "]");
+			}
+		}
+		else
+		{
+			if (!countOnly ())
+			{
+				mismatch ("Glyphs [" + in.names.getName (reverseMap[outId])
+					+ "] and [" + in.names.getName (inId)
+					+ "] are both renamed to [" + out.names.getName (outId) + "]");
+			}
+		}
+	}
+	return SUCCESS;
+}
+
+//! \fn int SfdVerifier::checkLigatures (void)
+//! \brief Check that each glyph has the same ligatures in both files, with
+//! the components renamed.
+//! \returns SUCCESS if the ligatures match.
+//! \returns FAIL if there is a mismatch.
+int SfdVerifier::checkLigatures (void)
+{
+	unsigned int before = mismatches;
+	const int *inComps = in.glyphs.getComps ();
+	const int *outComps = out.glyphs.getComps ();
+
+	for (unsigned int i = 0; i < in.glyphs.getCount (); i++)
+	{
+		const string& glyphName = in.names.getName (in.glyphs.getCurId (i));
+		unsigned int inLig = in.glyphs.getLigBegin (i);
+		unsigned int outLig = out.glyphs.getLigBegin (i);
+		if (in.glyphs.getLigatureCount (i) != out.glyphs.getLigatureCount (i))
+		{
+			if (!countOnly ())
+			{
+				mismatch ("Glyph [" + glyphName + "] has "
+					+ to_string (in.glyphs.getLigatureCount (i))
+					+ " ligature(s) in the input and "
+					+ to_string (out.glyphs.getLigatureCount (i))
+					+ " in the output");
+			}
+			continue;
+		}
+
+		for (; inLig < in.glyphs.getLigEnd (i); inLig++, outLig++)
+		{
+			unsigned int inComp = in.glyphs.getCompBegin (inLig);
+			unsigned int outComp = out.glyphs.getCompBegin (outLig);
+			unsigned int compCount = in.glyphs.getCompEnd (inLig) - inComp;
+			if ((in.glyphs.getFormCode (inLig) != out.glyphs.getFormCode (outLig))
+				|| (compCount != out.glyphs.getCompEnd (outLig) - outComp))
+			{
+				if (!countOnly ())
+				{
+					mismatch ("Ligature of glyph [" + glyphName
+						+ "] differs in the form or the number of glyphs");
+				}
+				continue;
+			}
+			for (unsigned int k = 0; k < compCount; k++)
+			{
+				int expected = mapName (inComps[inComp + k]);
+				if (expected != outComps[outComp + k])
+				{
+					if (!countOnly ())
+					{
+						mismatch ("Ligature of glyph [" + glyphName + "] has ["
+							+ in.names.getName (inComps[inComp + k]) + "] as ["
+							+ out.names.getName (outComps[outComp + k])
+							+ "] in the output, expected ["
+							+ ((expected == NO_ID) ? in.names.getName (inComps[inComp + k])
+							: out.names.getName (expected)) + "]");
+					}
+				}
+			}
+		}
+	}
+	return (mismatches == before) ? SUCCESS : FAIL;
+}
+
+//! \fn int SfdVerifier::checkSpans (void)
+//! \brief Compare the glyph names of the files one by one, and the data
+//! between them byte by byte.
+//! \returns SUCCESS if the files match.
+//! \returns FAIL if there is a mismatch. The comparison stops at the first
+//! difference in the data, the names after it are not paired.
+//!
+//! A byte count of a class list must be the count of the input changed by
+//! the difference in the length of the names it counts. The output ends
+//! with a new line even if the input does not.
+int SfdVerifier::checkSpans (void)
+{
+	unsigned int before = mismatches;
+	const char *inData = in.sfdBuf.getData ();
+	const char *outData = out.sfdBuf.getData ();
+	size_t inPos = 0;
+	size_t outPos = 0;
+	size_t count = min (in.vSpan.size (), out.vSpan.size ());
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const SfdSpan& inSpan = in.vSpan[i];
+		const SfdSpan& outSpan = out.vSpan[i];
+		size_t gap = inSpan.offset - inPos;
+		size_t outGap = outSpan.offset - outPos;
+		if ((gap != outGap)
+			|| (memcmp (inData + inPos, outData + outPos, gap) != 0)
+			|| (inSpan.type != outSpan.type)
+			|| ((inSpan.type == SPAN_COUNT) && (inSpan.count != outSpan.count)))
+		{
+			//! Without a differing byte in the gap, the spans differ.
+			size_t diff = firstDiff (inData + inPos, gap, outData + outPos,
+				outGap);
+			if (!countOnly ())
+			{
+				mismatch ("Line " + to_string (lineOf (in, inPos + diff))
+					+ " of the input and line "
+					+ to_string (lineOf (out, outPos + diff))
+					+ " of the output differ");
+			}
+			return FAIL;
+		}
+
+		if (inSpan.type == SPAN_COUNT)
+		{
+			long delta = 0;
+			for (int n = 1; (n <= inSpan.count) && (i + n < count); n++)
+			{
+				delta += (long) out.vSpan[i + n].length
+					- (long) in.vSpan[i + n].length;
+			}
+			int inCount = 0;
+			int outCount = 0;
+			parseInt (string_view (inData + inSpan.offset, inSpan.length), inCount);
+			parseInt (string_view (outData + outSpan.offset, outSpan.length),
+				outCount);
+			if (outCount != inCount + delta)
+			{
+				if (!countOnly ())
+				{
+					mismatch ("Line " + to_string (lineOf (in, inSpan.offset))
+						+ " : Byte count is " + to_string (outCount)
+						+ " in the output, expected " + to_string (inCount + delta));
+				}
+			}
+		}
+		else
+		{
+			compared++;
+			int expected = mapName (inSpan.nameId);
+			if (expected != outSpan.nameId)
+			{
+				if (!countOnly ())
+				{
+					mismatch ("Line " + to_string (lineOf (in, inSpan.offset))
+						+ " : [" + in.names.getName (inSpan.nameId) + "] is ["
+						+ out.names.getName (outSpan.nameId) + "] in the output,"
+						" expected [" + ((expected == NO_ID) ? in.names.getName (inSpan.nameId)
+						: out.names.getName (expected)) + "]");
+				}
+			}
+		}
+		inPos = inSpan.offset + inSpan.length;
+		outPos = outSpan.offset + outSpan.length;
+	}
+
+	if (in.vSpan.size () != out.vSpan.size ())
+	{
+		mismatch (to_string (in.vSpan.size ()) + " glyph name(s) in the input"
+			" and " + to_string (out.vSpan.size ()) + " in the output");
+		return FAIL;
+	}
+
+	size_t inTail = in.sfdBuf.getSize () - inPos;
+	size_t outTail = out.sfdBuf.getSize () - outPos;
+	bool newLine = (in.sfdBuf.getSize () > 0)
+		&& (inData[in.sfdBuf.getSize () - 1] != '\n');
+	if ((outTail != inTail + (newLine ? 1 : 0))
+		|| (memcmp (inData + inPos, outData + outPos, inTail) != 0)
+		|| (newLine && (outData[out.sfdBuf.getSize () - 1] != '\n')))
+	{
+		size_t diff = firstDiff (inData + inPos, inTail, outData + outPos,
+			outTail);
+		if (!countOnly ())
+		{
+			mismatch ("Line " + to_string (lineOf (in, inPos + diff))
+				+ " of the input and line "
+				+ to_string (lineOf (out, outPos + diff))
+				+ " of the output differ");
+		}
+	}
+	return (mismatches == before) ? SUCCESS : FAIL;
+}
+
+//! \fn int SfdVerifier::mapName (int inId)
+//! \brief Get the name the input name is expected to have in the output.
+//! Names that are not glyph names of the input are not renamed, they are
+//! added to the map as they are met. Such a name must not be the new name
+//! of a glyph.
+//! \param [in] inId ID of the name in the input.
+//! \returns ID of the name in the output.
+//! \returns NO_ID if the name is not in the output.
+int SfdVerifier::mapName (int inId)
+{
+	if (nameMap[inId] != NO_ID)
+	{
+		return nameMap[inId];
+	}
+
+	const string& name = in.names.getName (inId);
+	int outId = out.names.findId (name);
+	if (outId == NO_ID)
+	{
+		return NO_ID;
+	}
+	nameMap[inId] = outId;
+	if (reverseMap[outId] == NO_ID)
+	{
+		reverseMap[outId] = inId;
+	}
+	else if (reverseMap[outId] != inId)
+	{
+		if (!countOnly ())
+		{
+			mismatch ("[" + name + "] is not a glyph of the input, but glyph ["
+				+ in.names.getName (reverseMap[outId]) + "] is renamed to it");
+		}
+	}
+	return outId;
+}
+
+//! \fn bool SfdVerifier::countOnly (void)
+//! \brief Count a mismatch that is not reported, so that its message is
+//! not built.
+//! \returns true if the mismatch was counted, past VERIFY_MAX_REPORTS.
+//! \returns false if it is to be reported with mismatch ().
+bool SfdVerifier::countOnly (void)
+{
+	if (mismatches < VERIFY_MAX_REPORTS)
+	{
+		return false;
+	}
+	mismatches++;
+	return true;
+}
+
+//! Count the mismatch, log it if it is one of the first ones.
+void SfdVerifier::mismatch (const string& message)
+{
+	mismatches++;
+	if (mismatches <= VERIFY_MAX_REPORTS)
+	{
+		jERR (out.fileName << " : " << message);
+	}
+}
+
+//! Get the number of glyphs compared.
+unsigned int SfdVerifier::getGlyphCount (void)
+{
+	return in.glyphs.getCount ();
+}
+
+//! Get the number of glyph names renamed.
+unsigned int SfdVerifier::getRenamedCount (void)
+{
+	return renamed;
+}
+
+//! Get the number of glyph names compared, in StartChar lines and
+//! elsewhere.
+size_t SfdVerifier::getNameCount (void)
+{
+	return compared;
+}
+
+//! Get the number of mismatches found.
+unsigned int SfdVerifier::getMismatchCount (void)
+{
+	return mismatches;
+}
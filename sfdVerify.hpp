@@ -0,0 +1,90 @@
+#ifndef __SFDVERIFY_H
+#define __SFDVERIFY_H
+using namespace std;
+#include <string>
+#include <vector>
+#include "fontClass.hpp"
+#include "sfdBuffer.hpp"
+//! \file sfdVerify.hpp
+//! \brief Check that a SFD file is a correct rename of another.
+
+//! Mismatches reported for a pair of files, the others are only counted.
+#define VERIFY_MAX_REPORTS 20
+
+//! A SFD file parsed for verification.
+struct VerifySide
+{
+	string fileName; //!< Name of the SFD file.
+	SfdBuffer sfdBuf; //!< Contents of the file.
+	NameTable names; //!< Glyph names of the file.
+	GlyphStore glyphs; //!< Glyphs of the file.
+	vector<SfdSpan> vSpan; //!< Location of the glyph names, in file order.
+	size_t lineOffset = 0; //!< Offset up to which the lines are counted.
+	size_t lineCount = 1; //!< Number of the line holding lineOffset.
+};
+
+//! Checks that the output of a run differs from the input only in the
+//! glyph names, without generating and rendering the fonts:
+//! -# The glyphs of the files correspond one to one in file order, every
+//! old name is given a single new name and no two old names the same one.
+//! -# The ligatures of each glyph have the same forms and components,
+//! after mapping the component names.
+//! -# Every other glyph name, in the substitutions, classes and
+//! contextual lookups, is the mapped name, and the byte counts of the
+//! class lists match the new names.
+//! -# All the data other than the names and counts is byte identical.
+//!
+//! Names that are not glyph names in the input must be unchanged.
+class SfdVerifier
+{
+public:
+	SfdVerifier ();
+	SfdVerifier (const SfdVerifier&) = delete;
+	SfdVerifier& operator= (const SfdVerifier&) = delete;
+
+	//! Check that outFile is a rename of inFile.
+	int verify (const string& inFile, const string& outFile, unsigned int threads);
+
+	//! Get the number of glyphs compared.
+	unsigned int getGlyphCount (void);
+
+	//! Get the number of glyph names renamed.
+	unsigned int getRenamedCount (void);
+
+	//! Get the number of glyph names compared.
+	size_t getNameCount (void);
+
+	//! Get the number of mismatches found.
+	unsigned int getMismatchCount (void);
+private:
+	//! Parse a SFD file.
+	int load (VerifySide& side, const string& fileName, unsigned int threads);
+
+	//! Build the name map from the StartChar lines.
+	int checkGlyphs (void);
+
+	//! Compare the ligatures of the glyphs.
+	int checkLigatures (void);
+
+	//! Compare the names and the data between them.
+	int checkSpans (void);
+
+	//! Get the ID in the output of the name the input name maps to.
+	int mapName (int inId);
+
+	//! Count a mismatch past the reported ones.
+	bool countOnly (void);
+
+	//! Count and report a mismatch.
+	void mismatch (const string& message);
+
+	VerifySide in; //!< The input of the run.
+	VerifySide out; //!< The output of the run.
+	vector<int> nameMap; //!< Output name ID, indexed by input name ID.
+	vector<int> reverseMap; //!< Input name ID, indexed by output name ID.
+	unsigned int renamed; //!< Glyph names that differ.
+	size_t compared; //!< Glyph names compared.
+	unsigned int mismatches; //!< Mismatches found.
+};
+
+#endif
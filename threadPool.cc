@@ -0,0 +1,136 @@
+#include "threadPool.hpp"
+//! \file threadPool.cc
+//! \brief ThreadPool implementation
+
+//! \fn ThreadPool::ThreadPool (unsigned int workerCount)
+//! \brief Start the worker threads.
+//! \param [in] workerCount Number of workers, 0 is taken as 1.
+ThreadPool::ThreadPool (unsigned int workerCount)
+{
+	if (workerCount == 0)
+	{
+		workerCount = 1;
+	}
+
+	nextQueue = 0;
+	available = 0;
+	unfinished = 0;
+	stopping = false;
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		queues.push_back (make_unique<WorkQueue> ());
+	}
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		workers.emplace_back (&ThreadPool::workerLoop, this, i);
+	}
+}
+
+//! Finish the queued tasks and join the workers.
+ThreadPool::~ThreadPool ()
+{
+	{
+		lock_guard<mutex> lk (stateLock);
+		stopping = true;
+	}
+	workReady.notify_all ();
+	for (unsigned int i = 0; i < workers.size (); i++)
+	{
+		workers[i].join ();
+	}
+}
+
+//! \fn void ThreadPool::submit (function<void (void)> task)
+//! \brief Queue a task, the queues are used in round robin order.
+//! \param [in] task The task.
+void ThreadPool::submit (function<void (void)> task)
+{
+	unsigned int q;
+	{
+		lock_guard<mutex> lk (stateLock);
+		q = nextQueue;
+		nextQueue = (nextQueue + 1) % queues.size ();
+	}
+
+	{
+		lock_guard<mutex> lk (queues[q]->lock);
+		queues[q]->tasks.push_back (move (task));
+	}
+
+	{
+		lock_guard<mutex> lk (stateLock);
+		available++;
+		unfinished++;
+	}
+	workReady.notify_one ();
+}
+
+//! Wait until all the submitted tasks are finished.
+void ThreadPool::wait (void)
+{
+	unique_lock<mutex> lk (stateLock);
+	allDone.wait (lk, [this] {return unfinished == 0;});
+}
+
+//! get method for the number of workers
+unsigned int ThreadPool::getWorkerCount (void)
+{
+	return workers.size ();
+}
+
+//! \fn void ThreadPool::takeTask (unsigned int self, function<void (void)>& task)
+//! \brief Take the next task, from the own queue if possible.
+//! The caller has reserved a task by decrementing available, so one is
+//! present in some queue.
+//! \param [in] self Index of the worker.
+//! \param [out] task The task.
+void ThreadPool::takeTask (unsigned int self, function<void (void)>& task)
+{
+	while (1)
+	{
+		for (unsigned int n = 0; n < queues.size (); n++)
+		{
+			WorkQueue& q = *queues[(self + n) % queues.size ()];
+			lock_guard<mutex> lk (q.lock);
+			if (!q.tasks.empty ())
+			{
+				task = move (q.tasks.front ());
+				q.tasks.pop_front ();
+				return;
+			}
+		}
+		//! Other workers took the tasks seen in the scan, scan again.
+		this_thread::yield ();
+	}
+}
+
+//! \fn void ThreadPool::workerLoop (unsigned int self)
+//! \brief Body of the worker threads.
+//! \param [in] self Index of the worker.
+void ThreadPool::workerLoop (unsigned int self)
+{
+	while (1)
+	{
+		{
+			unique_lock<mutex> lk (stateLock);
+			workReady.wait (lk, [this] {return available > 0 || stopping;});
+			if (available == 0)
+			{
+				return;
+			}
+			available--;
+		}
+
+		function<void (void)> task;
+		takeTask (self, task);
+		task ();
+
+		lock_guard<mutex> lk (stateLock);
+		unfinished--;
+		if (unfinished == 0)
+		{
+			allDone.notify_all ();
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef __THREADPOOL_H
+#define __THREADPOOL_H
+using namespace std;
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+//! \file threadPool.hpp
+//! \brief Fixed size pool of worker threads with work stealing.
+
+//! Runs tasks on a fixed number of worker threads.
+//! Every worker has its own queue, tasks are spread over the queues in
+//! the order they are submitted. A worker takes the tasks from the front
+//! of its own queue and, once it is empty, steals from the front of the
+//! other queues. Tasks submitted in decreasing order of cost are thus
+//! started in that order whichever worker runs them.
+class ThreadPool
+{
+public:
+	//! Start the workers, at least one.
+	ThreadPool (unsigned int workerCount);
+
+	//! Finish the queued tasks and stop the workers.
+	~ThreadPool ();
+
+	ThreadPool (const ThreadPool&) = delete;
+	ThreadPool& operator= (const ThreadPool&) = delete;
+
+	//! Queue a task.
+	void submit (function<void (void)> task);
+
+	//! Wait until all the submitted tasks are finished.
+	void wait (void);
+
+	//! get method for the number of workers
+	unsigned int getWorkerCount (void);
+
+private:
+	//! Tasks queued for one worker.
+	struct WorkQueue
+	{
+		mutex lock;
+		deque<function<void (void)> > tasks;
+	};
+
+	void workerLoop (unsigned int self);
+	void takeTask (unsigned int self, function<void (void)>& task);
+
+	vector<unique_ptr<WorkQueue> > queues; //!< One queue per worker.
+	vector<thread> workers;
+	mutex stateLock; //!< Protects the counters below.
+	condition_variable workReady;
+	condition_variable allDone;
+	unsigned int nextQueue; //!< Queue for the next submitted task.
+	unsigned long available; //!< Tasks queued and not yet taken.
+	unsigned long unfinished; //!< Tasks submitted and not yet finished.
+	bool stopping;
+};
+
+#endif